@@ -161,9 +161,11 @@ public class IArabicSpeechRecognizer {
     }
 
     /// Load a Whisper model from disk
-    /// - Parameter modelPath: Path to the CTranslate2 model directory
+    /// - Parameters:
+    ///   - modelPath: Path to the CTranslate2 model directory
+    ///   - numWorkers: Number of model replicas used to decode segments in parallel
     /// - Throws: Error if model cannot be loaded
-    public func loadModel(path modelPath: String) throws {
+    public func loadModel(path modelPath: String, numWorkers: Int = 1) throws {
         // Clean up existing model if any
         if let handle = modelHandle {
             whisper_destroy_model(handle)
@@ -177,7 +179,7 @@ public class IArabicSpeechRecognizer {
             throw SpeechRecognitionError.invalidModelPath
         }
 
-        guard let handle = whisper_create_model(path) else {
+        guard let handle = whisper_create_model_with_workers(path, Int32(numWorkers)) else {
             throw SpeechRecognitionError.modelLoadFailed
         }
 
@@ -190,13 +192,40 @@ public class IArabicSpeechRecognizer {
         return isModelLoaded
     }
 
+    /// Trade-off between latency and accuracy for transcription
+    public enum LatencyProfile: String {
+        /// Greedy decoding without temperature fallback or word timestamps
+        case realtime
+        /// Small beam with a short temperature fallback
+        case balanced
+        /// Full beam search and fallback schedule
+        case accurate
+    }
+
+    /// Holds the segment handler while the C callback can reach it
+    private final class SegmentHandler {
+        let onSegment: ((TranscriptionSegment, Float, Float) -> Void)?
+
+        init(_ onSegment: ((TranscriptionSegment, Float, Float) -> Void)?) {
+            self.onSegment = onSegment
+        }
+    }
+
     /// Transcribe speech from audio data with detailed results
     /// - Parameters:
     ///   - audio: Audio samples as float array
     ///   - language: Optional language code (e.g., "ar", "en"). If nil, auto-detect.
+    ///   - profile: Latency profile used to pick decoding options
+    ///   - onSegment: Optional handler called with each segment as soon as it is final,
+    ///     the seconds processed and the total seconds, on the decoding thread
     /// - Returns: Transcription result with segments and metadata
     /// - Throws: Error if transcription fails
-    public func transcribe(audio: [Float], language: String? = nil) throws -> TranscriptionResult {
+    public func transcribe(
+        audio: [Float],
+        language: String? = nil,
+        profile: LatencyProfile = .accurate,
+        onSegment: ((TranscriptionSegment, Float, Float) -> Void)? = nil
+    ) throws -> TranscriptionResult {
         guard isModelLoaded, let handle = modelHandle else {
             throw SpeechRecognitionError.modelNotLoaded
         }
@@ -208,7 +237,33 @@ public class IArabicSpeechRecognizer {
         } else {
             cLanguage = nil
         }
-        var result = whisper_transcribe(handle, audio, UInt(audio.count), cLanguage)
+        var options = WhisperDecodingOptions()
+        guard whisper_decoding_options(profile.rawValue, &options) != 0 else {
+            throw SpeechRecognitionError.recognitionFailed
+        }
+        let handler = Unmanaged.passRetained(SegmentHandler(onSegment))
+        defer { handler.release() }
+        var result = whisper_transcribe_with_options(
+            handle, audio, UInt(audio.count), cLanguage, &options,
+            { segment, processedSeconds, totalSeconds, userData in
+                guard let segment = segment, let userData = userData, let text = segment.pointee.text else {
+                    return
+                }
+                let handler = Unmanaged<SegmentHandler>.fromOpaque(userData).takeUnretainedValue()
+                handler.onSegment?(
+                    TranscriptionSegment(text: String(cString: text), start: segment.pointee.start, end: segment.pointee.end),
+                    processedSeconds,
+                    totalSeconds
+                )
+            },
+            handler.toOpaque(),
+            nil
+        )
+
+        if result.status == Int32(TRANSCRIPTION_FAILED.rawValue) {
+            whisper_free_transcription_result(result)
+            throw SpeechRecognitionError.recognitionFailed
+        }
 
         // Convert C result to Swift
         var segments: [TranscriptionSegment] = []
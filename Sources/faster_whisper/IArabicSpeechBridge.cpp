@@ -9,9 +9,12 @@
 #include "whisper/whisper_audio.h"
 #include "feature_extractor.h"
 #include "transcribe.h"
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <stdexcept>
 
 extern "C" {
 
@@ -111,6 +114,10 @@ void whisper_free_float_matrix(FloatMatrix matrix) {
 // Model management and transcription functions
 
 WhisperModelHandle whisper_create_model(const char* model_path) {
+    return whisper_create_model_with_workers(model_path, 1);
+}
+
+WhisperModelHandle whisper_create_model_with_workers(const char* model_path, int num_workers) {
     if (!model_path) {
         return nullptr;
     }
@@ -123,7 +130,7 @@ WhisperModelHandle whisper_create_model(const char* model_path) {
             {0},                  // device_index (at least one device needed)
             "float32",            // compute_type
             0,                    // cpu_threads (0 = auto)
-            1,                    // num_workers
+            num_workers,          // num_workers
             "",                   // download_root
             false,                // local_files_only
             {},                   // files
@@ -149,7 +156,100 @@ TranscriptionResult whisper_transcribe(
     unsigned long audio_length,
     const char* language
 ) {
-    TranscriptionResult result = {nullptr, 0, nullptr, 0.0f, 0.0f};
+    return whisper_transcribe_streaming(model, audio, audio_length, language, nullptr, nullptr);
+}
+
+TranscriptionResult whisper_transcribe_streaming(
+    WhisperModelHandle model,
+    const float* audio,
+    unsigned long audio_length,
+    const char* language,
+    TranscriptionSegmentCallback callback,
+    void* user_data
+) {
+    return whisper_transcribe_with_control(model, audio, audio_length, language, callback, user_data, nullptr);
+}
+
+WhisperTranscriptionControlHandle whisper_create_transcription_control(double timeout_seconds) {
+    if (timeout_seconds <= 0.0) {
+        return static_cast<WhisperTranscriptionControlHandle>(new TranscriptionControl());
+    }
+    auto timeout = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(timeout_seconds)
+    );
+    return static_cast<WhisperTranscriptionControlHandle>(
+        new TranscriptionControl(std::chrono::steady_clock::now() + timeout)
+    );
+}
+
+void whisper_cancel_transcription(WhisperTranscriptionControlHandle control) {
+    if (control) {
+        static_cast<TranscriptionControl*>(control)->cancel();
+    }
+}
+
+void whisper_destroy_transcription_control(WhisperTranscriptionControlHandle control) {
+    if (control) {
+        delete static_cast<TranscriptionControl*>(control);
+    }
+}
+
+TranscriptionResult whisper_transcribe_with_control(
+    WhisperModelHandle model,
+    const float* audio,
+    unsigned long audio_length,
+    const char* language,
+    TranscriptionSegmentCallback callback,
+    void* user_data,
+    WhisperTranscriptionControlHandle control
+) {
+    return whisper_transcribe_with_options(
+        model, audio, audio_length, language, nullptr, callback, user_data, control
+    );
+}
+
+int whisper_decoding_options(const char* profile, WhisperDecodingOptions* options) {
+    if (!profile || !options) {
+        return 0;
+    }
+
+    try {
+        TranscriptionOptions profile_options = WhisperModel::latency_profile(profile);
+
+        options->beam_size = profile_options.beam_size;
+        options->best_of = profile_options.best_of;
+        options->patience = profile_options.patience;
+        options->temperature_count = static_cast<int>(
+            std::min<size_t>(profile_options.temperatures.size(), WHISPER_MAX_TEMPERATURES)
+        );
+        for (int i = 0; i < options->temperature_count; ++i) {
+            options->temperatures[i] = profile_options.temperatures[i];
+        }
+        options->word_timestamps = profile_options.word_timestamps ? 1 : 0;
+        options->condition_on_previous_text = profile_options.condition_on_previous_text ? 1 : 0;
+        options->speculative_fallback = profile_options.speculative_fallback ? 1 : 0;
+        options->adaptive_beam = profile_options.adaptive_beam ? 1 : 0;
+        options->decode_chunk_tokens = profile_options.decode_chunk_tokens;
+        options->hallucination_silence_threshold = profile_options.hallucination_silence_threshold.value_or(0.0f);
+        options->clip_timestamps = nullptr;
+        return 1;
+    } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        return 0;
+    }
+}
+
+TranscriptionResult whisper_transcribe_with_options(
+    WhisperModelHandle model,
+    const float* audio,
+    unsigned long audio_length,
+    const char* language,
+    const WhisperDecodingOptions* options,
+    TranscriptionSegmentCallback callback,
+    void* user_data,
+    WhisperTranscriptionControlHandle control
+) {
+    TranscriptionResult result = {nullptr, 0, nullptr, 0.0f, 0.0f, TRANSCRIPTION_COMPLETED};
 
     if (!model || !audio || audio_length == 0) {
         return result;
@@ -163,7 +263,40 @@ TranscriptionResult whisper_transcribe(
 
         // Transcribe
         std::optional<std::string> lang = language ? std::optional<std::string>(language) : std::nullopt;
-        auto [segments, info] = whisper_model->transcribe(audio_vec, lang, true);
+        SegmentCallback on_segment;
+        if (callback) {
+            on_segment = [callback, user_data](const Segment& seg, const TranscriptionProgress& progress) {
+                TranscriptionSegment c_segment = {const_cast<char*>(seg.text.c_str()), seg.start, seg.end};
+                callback(&c_segment, progress.processed_seconds, progress.total_seconds, user_data);
+            };
+        }
+        TranscriptionOptions transcription_options = WhisperModel::default_options(true);
+        if (options) {
+            transcription_options.beam_size = std::max(1, options->beam_size);
+            transcription_options.best_of = std::max(1, options->best_of);
+            transcription_options.patience = options->patience;
+            int temperature_count = std::clamp(options->temperature_count, 0, WHISPER_MAX_TEMPERATURES);
+            if (temperature_count > 0) {
+                transcription_options.temperatures.assign(
+                    options->temperatures, options->temperatures + temperature_count
+                );
+            }
+            transcription_options.word_timestamps = options->word_timestamps != 0;
+            transcription_options.condition_on_previous_text = options->condition_on_previous_text != 0;
+            transcription_options.speculative_fallback = options->speculative_fallback != 0;
+            transcription_options.adaptive_beam = options->adaptive_beam != 0;
+            transcription_options.decode_chunk_tokens = std::max(0, options->decode_chunk_tokens);
+            if (options->hallucination_silence_threshold > 0.0f) {
+                transcription_options.hallucination_silence_threshold = options->hallucination_silence_threshold;
+            }
+            if (options->clip_timestamps) {
+                transcription_options.clip_timestamps = std::string(options->clip_timestamps);
+            }
+        }
+        auto [segments, info] = whisper_model->transcribe(
+            audio_vec, transcription_options, lang, false, MelVadOptions(), on_segment,
+            static_cast<const TranscriptionControl*>(control)
+        );
 
         // Allocate and copy segments
         result.segment_count = segments.size();
@@ -191,8 +324,21 @@ TranscriptionResult whisper_transcribe(
         result.language_probability = info.language_probability;
         result.duration = info.duration;
 
+        switch (info.status) {
+            case TranscriptionStatus::Completed:
+                result.status = TRANSCRIPTION_COMPLETED;
+                break;
+            case TranscriptionStatus::Cancelled:
+                result.status = TRANSCRIPTION_CANCELLED;
+                break;
+            case TranscriptionStatus::DeadlineExceeded:
+                result.status = TRANSCRIPTION_DEADLINE_EXCEEDED;
+                break;
+        }
+
     } catch (const std::exception& e) {
         std::cerr << "Transcription failed: " << e.what() << std::endl;
+        result.status = TRANSCRIPTION_FAILED;
     }
 
     return result;
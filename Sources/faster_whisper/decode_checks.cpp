@@ -0,0 +1,178 @@
+///
+/// decode_checks.cpp
+/// IArabicSpeech
+///
+
+#include "decode_checks.h"
+#include <algorithm>
+#include <sstream>
+
+bool TranscriptionControl::should_stop() const {
+  if (status_.load() != TranscriptionStatus::Completed) {
+    return true;
+  }
+
+  TranscriptionStatus reason = TranscriptionStatus::Completed;
+  if (cancelled_.load()) {
+    reason = TranscriptionStatus::Cancelled;
+  } else if (deadline_.has_value() && std::chrono::steady_clock::now() >= deadline_.value()) {
+    reason = TranscriptionStatus::DeadlineExceeded;
+  }
+  if (reason == TranscriptionStatus::Completed) {
+    return false;
+  }
+
+  TranscriptionStatus expected = TranscriptionStatus::Completed;
+  status_.compare_exchange_strong(expected, reason);
+  return true;
+}
+
+std::vector<float> parse_clip_timestamps(const std::variant<std::string, std::vector<float>> &clip_timestamps) {
+  if (std::holds_alternative<std::vector<float>>(clip_timestamps)) {
+    return std::get<std::vector<float>>(clip_timestamps);
+  }
+
+  // Comma-separated seconds, empty entries skipped (Python line 1100-1106)
+  std::vector<float> timestamps;
+  std::stringstream stream(std::get<std::string>(clip_timestamps));
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    size_t first = item.find_first_not_of(" \t");
+    if (first == std::string::npos) continue;
+    size_t last = item.find_last_not_of(" \t");
+    timestamps.push_back(std::stof(item.substr(first, last - first + 1)));
+  }
+  return timestamps;
+}
+
+bool has_repetition_loop(const std::vector<int> &tokens, int eot, int min_repeats) {
+  // True when the text tokens end with one n-gram repeated min_repeats times;
+  // timestamps are skipped since they keep increasing inside a loop
+  if (min_repeats < 2) return false;
+  std::vector<int> text;
+  for (int token: tokens) {
+    if (token < eot) text.push_back(token);
+  }
+
+  for (size_t n = 1; n * min_repeats <= text.size(); ++n) {
+    size_t start = text.size() - n * min_repeats;
+    bool loop = true;
+    for (size_t i = start + n; i < text.size() && loop; ++i) {
+      loop = text[i] == text[i - n];
+    }
+    if (loop) return true;
+  }
+  return false;
+}
+
+bool is_silent_window(float no_speech_prob, float avg_logprob, const TranscriptionOptions &options) {
+  if (!options.no_speech_threshold.has_value() || no_speech_prob <= options.no_speech_threshold.value()) {
+    return false;
+  }
+  return !options.log_prob_threshold.has_value() || avg_logprob <= options.log_prob_threshold.value();
+}
+
+float word_anomaly_score(const Word &word) {
+  // Python word_anomaly_score: unlikely, very short or very long words
+  float duration = word.end - word.start;
+  float score = 0.0f;
+  if (word.probability < 0.15f) score += 1.0f;
+  if (duration < 0.133f) score += (0.133f - duration) * 15.0f;
+  if (duration > 2.0f) score += duration - 2.0f;
+  return score;
+}
+
+bool is_segment_anomaly(const Segment *segment) {
+  // Python is_segment_anomaly, scored over the first 8 non-punctuation words
+  static const std::string punctuation = "\"'“¿([{-\"'.。,，!！?？:：”)]}、";
+  if (!segment || !segment->words.has_value() || segment->words->empty()) return false;
+
+  float score = 0.0f;
+  size_t count = 0;
+  for (const auto &word: segment->words.value()) {
+    if (punctuation.find(word.word) != std::string::npos) continue;
+    score += word_anomaly_score(word);
+    if (++count == 8) break;
+  }
+  return score >= 3.0f || score + 0.01f >= count;
+}
+
+std::vector<std::pair<float, float>> alignment_word_times(
+  const std::vector<std::pair<ctranslate2::dim_t, ctranslate2::dim_t>> &alignments,
+  const std::vector<size_t> &word_token_counts,
+  float time_precision
+) {
+  // Time of each step where the path moves on to the next token
+  std::vector<float> jump_times;
+  for (size_t k = 0; k < alignments.size(); ++k) {
+    if (k == 0 || alignments[k].first != alignments[k - 1].first) {
+      jump_times.push_back(alignments[k].second * time_precision);
+    }
+  }
+  if (jump_times.empty()) {
+    return {};
+  }
+
+  std::vector<std::pair<float, float>> word_times;
+  size_t word_start = 0;
+  for (size_t count : word_token_counts) {
+    size_t word_end = word_start + count;
+    word_times.emplace_back(
+      jump_times[std::min(word_start, jump_times.size() - 1)],
+      jump_times[std::min(word_end, jump_times.size() - 1)]
+    );
+    word_start = word_end;
+  }
+  return word_times;
+}
+
+float median_word_duration(std::vector<float> durations) {
+  if (durations.empty()) {
+    return 0.0f;
+  }
+
+  // np.median: an even count averages the two middle values
+  size_t mid = durations.size() / 2;
+  std::nth_element(durations.begin(), durations.begin() + mid, durations.end());
+  float median = durations[mid];
+  if (durations.size() % 2 == 0) {
+    median = (median + *std::max_element(durations.begin(), durations.begin() + mid)) / 2.0f;
+  }
+  return std::min(0.7f, median);
+}
+
+void clamp_segment_words(
+  std::vector<Word> &words,
+  float &segment_start,
+  float &segment_end,
+  float median_duration,
+  float max_duration,
+  float last_speech_timestamp
+) {
+  if (words.empty()) {
+    return;
+  }
+
+  // A long first word after a pause is likely stretched over the silence
+  if (words[0].end - last_speech_timestamp > median_duration * 4 &&
+      (words[0].end - words[0].start > max_duration ||
+       (words.size() > 1 && words[1].end - words[0].start > max_duration * 2))) {
+    if (words.size() > 1 && words[1].end - words[1].start > max_duration) {
+      float boundary = std::max(words[1].end / 2, words[1].end - max_duration);
+      words[0].end = words[1].start = boundary;
+    }
+    words[0].start = std::max(0.0f, words[0].end - max_duration);
+  }
+
+  if (segment_start < words[0].end && segment_start - 0.5f > words[0].start) {
+    words[0].start = std::max(0.0f, std::min(words[0].end - median_duration, segment_start));
+  } else {
+    segment_start = words[0].start;
+  }
+
+  if (segment_end > words.back().start && segment_end + 0.5f < words.back().end) {
+    words.back().end = std::max(words.back().start + median_duration, segment_end);
+  } else {
+    segment_end = words.back().end;
+  }
+}
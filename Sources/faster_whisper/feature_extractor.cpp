@@ -467,3 +467,92 @@ Matrix FeatureExtractor::compute_mel_spectrogram_original(
 
   return log_spec;
 }
+
+std::vector<std::pair<int, int>> FeatureExtractor::detect_speech(
+    const Matrix& features,
+    const MelVadOptions& options
+) const {
+  std::vector<std::pair<int, int>> regions;
+  if (features.empty() || features[0].empty()) {
+    return regions;
+  }
+
+  const size_t n_mels = features.size();
+  const int n_frames = static_cast<int>(features[0].size());
+
+  // Mean band level and positive spectral flux per frame. The matrix is stored
+  // band-major, so walk each band row once and accumulate into the frame arrays.
+  std::vector<float> energy(n_frames, 0.0f);
+  std::vector<float> flux(n_frames, 0.0f);
+  for (const auto& band : features) {
+    energy[0] += band[0];
+    for (int t = 1; t < n_frames; ++t) {
+      energy[t] += band[t];
+      flux[t] += std::max(0.0f, band[t] - band[t - 1]);
+    }
+  }
+
+  std::vector<float> score(n_frames);
+  for (int t = 0; t < n_frames; ++t) {
+    energy[t] /= n_mels;
+    score[t] = energy[t] + options.flux_weight * flux[t] / n_mels;
+  }
+
+  // Adaptive threshold between the noise floor and the speech peak percentiles
+  std::vector<float> sorted_score = score;
+  std::sort(sorted_score.begin(), sorted_score.end());
+  float noise_floor = sorted_score[static_cast<size_t>(0.10f * (n_frames - 1))];
+  float speech_peak = sorted_score[static_cast<size_t>(0.95f * (n_frames - 1))];
+  float max_energy = *std::max_element(energy.begin(), energy.end());
+
+  if (speech_peak - noise_floor < options.min_dynamic_range) {
+    // No contrast to separate speech from background: either all of it or none
+    if (max_energy >= options.min_energy) {
+      regions.emplace_back(0, n_frames);
+    }
+    return regions;
+  }
+
+  float threshold = noise_floor + options.threshold * (speech_peak - noise_floor);
+
+  // Raw speech runs
+  std::vector<std::pair<int, int>> runs;
+  int run_start = -1;
+  for (int t = 0; t < n_frames; ++t) {
+    bool is_speech = score[t] >= threshold && energy[t] >= options.min_energy;
+    if (is_speech && run_start < 0) {
+      run_start = t;
+    } else if (!is_speech && run_start >= 0) {
+      runs.emplace_back(run_start, t);
+      run_start = -1;
+    }
+  }
+  if (run_start >= 0) {
+    runs.emplace_back(run_start, n_frames);
+  }
+
+  // Bridge short pauses, then drop blips that are too short to be speech
+  std::vector<std::pair<int, int>> merged;
+  for (const auto& run : runs) {
+    if (!merged.empty() && run.first - merged.back().second < options.min_silence_frames) {
+      merged.back().second = run.second;
+    } else {
+      merged.push_back(run);
+    }
+  }
+
+  for (const auto& run : merged) {
+    if (run.second - run.first < options.min_speech_frames) {
+      continue;
+    }
+    int start = std::max(0, run.first - options.speech_pad_frames);
+    int end = std::min(n_frames, run.second + options.speech_pad_frames);
+    if (!regions.empty() && start <= regions.back().second) {
+      regions.back().second = end;
+    } else {
+      regions.emplace_back(start, end);
+    }
+  }
+
+  return regions;
+}
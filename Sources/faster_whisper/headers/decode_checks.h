@@ -0,0 +1,57 @@
+///
+/// decode_checks.h
+/// IArabicSpeech
+///
+
+#ifndef DECODE_CHECKS_H
+#define DECODE_CHECKS_H
+
+#include "transcribe.h"
+#include <string>
+#include <variant>
+#include <vector>
+
+// Clip boundaries in seconds from a comma-separated string or a list; blank
+// entries are skipped, as in faster-whisper.
+std::vector<float> parse_clip_timestamps(const std::variant<std::string, std::vector<float>> &clip_timestamps);
+
+// True when the text tokens (below eot) end with one n-gram repeated
+// min_repeats times. Timestamps are ignored since they keep increasing in a loop.
+bool has_repetition_loop(const std::vector<int> &tokens, int eot, int min_repeats);
+
+// True when a decoded window is silence: the no-speech probability is over
+// no_speech_threshold and the average log-probability is not above
+// log_prob_threshold (Python line 1201-1221).
+bool is_silent_window(float no_speech_prob, float avg_logprob, const TranscriptionOptions &options);
+
+// faster-whisper's hallucination scores: a word adds up to one point for being
+// unlikely, very short or very long, and a segment is an anomaly when its
+// first 8 non-punctuation words score 3 or average close to 1.
+float word_anomaly_score(const Word &word);
+bool is_segment_anomaly(const Segment *segment);
+
+// Start and end of each word from the DTW path of an align call: a word runs
+// from the step where the path reaches its first token to the step where it
+// reaches the next word (Python line 1665-1700). Empty for an empty path.
+std::vector<std::pair<float, float>> alignment_word_times(
+  const std::vector<std::pair<ctranslate2::dim_t, ctranslate2::dim_t>> &alignments,
+  const std::vector<size_t> &word_token_counts,
+  float time_precision
+);
+
+// Median word duration as np.median, capped at 0.7s; 0 without words.
+float median_word_duration(std::vector<float> durations);
+
+// Keeps the first and last words within sensible bounds of the segment
+// timestamps; the segment bounds move to the words when those are kept
+// (Python line 1617-1653).
+void clamp_segment_words(
+  std::vector<Word> &words,
+  float &segment_start,
+  float &segment_end,
+  float median_duration,
+  float max_duration,
+  float last_speech_timestamp
+);
+
+#endif // DECODE_CHECKS_H
@@ -10,10 +10,30 @@
 
 #include <vector>
 #include <complex>
+#include <optional>
+#include <utility>
 
 // A simple 2D vector to represent a matrix, analogous to a NumPy array.
 using Matrix = std::vector<std::vector<float>>;
 
+// Voice activity detection over an already computed log-mel spectrogram.
+// Levels are in the normalized log-mel scale produced by compute_mel_spectrogram
+// ((log10(power) + 4) / 4), so digital silence sits at -1.5.
+struct MelVadOptions {
+  // Position between the noise floor and the speech peak a frame must reach.
+  float threshold = 0.35f;
+  // Frames whose mean band level is below this are never speech.
+  float min_energy = -0.8f;
+  // Below this floor-to-peak range the clip is treated as a single region.
+  float min_dynamic_range = 0.25f;
+  // Weight of the positive spectral flux added to the band energy.
+  float flux_weight = 1.0f;
+  // Region length limits, in frames (10 ms each with the default hop).
+  int min_speech_frames = 25;
+  int min_silence_frames = 50;
+  int speech_pad_frames = 20;
+};
+
 class FeatureExtractor {
 public:
   // C++ constructor to match the Python `__init__`
@@ -44,6 +64,13 @@ public:
     return compute_mel_spectrogram(audio);
   }
 
+  // Speech regions of a mel spectrogram as [start_frame, end_frame) pairs,
+  // computed from per-frame band energy and spectral flux.
+  std::vector<std::pair<int, int>> detect_speech(
+      const Matrix& features,
+      const MelVadOptions& options = MelVadOptions()
+  ) const;
+
   float time_per_frame() const { return time_per_frame_; }
   int nb_max_frames() const { return nb_max_frames_; }
   int sampling_rate() const { return sampling_rate_; }
@@ -0,0 +1,46 @@
+///
+/// speech_chunks.h
+/// IArabicSpeech
+///
+
+#ifndef SPEECH_CHUNKS_H
+#define SPEECH_CHUNKS_H
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A speech chunk as {"start", "end"} sample positions in the original audio,
+// matching the dictionaries produced by faster-whisper's VAD.
+using SpeechChunk = std::map<std::string, float>;
+
+// Maps timestamps in audio made of concatenated speech chunks back to the
+// original audio, as faster-whisper's SpeechTimestampsMap does.
+class SpeechTimestampsMap {
+public:
+  SpeechTimestampsMap(const std::vector<SpeechChunk> &speech_chunks,
+                      int sampling_rate,
+                      int time_precision = 2);
+
+  // Index of the chunk containing time t (seconds in concatenated audio).
+  int get_chunk_index(float t, bool is_end = false) const;
+
+  // Original time of t; chunk_index < 0 looks the chunk up from t itself.
+  float get_original_time(float t, int chunk_index = -1, bool is_end = false) const;
+
+private:
+  int sampling_rate_;
+  int time_precision_;
+  std::vector<long> chunk_end_sample_;
+  std::vector<float> total_silence_before_;
+};
+
+// Splits frame ranges longer than max_frames and packs them greedily, in
+// order, into windows whose total length is at most max_frames.
+std::vector<std::vector<std::pair<int, int>>> pack_speech_chunks(
+  const std::vector<std::pair<int, int>> &regions,
+  int max_frames
+);
+
+#endif // SPEECH_CHUNKS_H
@@ -40,6 +40,14 @@ public:
     std::optional<std::string> vocab_path = std::nullopt
   );
 
+  // Constructor with a mapped vocabulary cache shared by every tokenizer
+  Tokenizer(
+    std::shared_ptr<const whisper::VocabCache> vocab_cache,
+    bool multilingual,
+    std::optional<std::string> task = std::nullopt,
+    std::optional<std::string> language = std::nullopt
+  );
+
 #ifndef NO_CTRANSLATE2
   // Constructor with CTranslate2 vocabulary
   Tokenizer(
@@ -62,12 +70,20 @@ public:
 
   // C++ equivalent of the properties.
   int get_timestamp_begin();
-  std::vector<int> get_sot_sequence();
+  const std::vector<int>& get_sot_sequence() const;
+
+  // Switch the language of the SOT sequence in constant time. Copies of a
+  // tokenizer share its vocabulary, so a copy can switch per window without
+  // affecting the original. Has no effect on English-only tokenizers.
+  void set_language(const std::string& language_code);
+  const std::string& get_language_code() const;
 
   // C++ equivalent of the Python methods.
   std::vector<int> encode(const std::string& text);
   std::string decode(const std::vector<int>& tokens);
   std::string decode_with_timestamps(const std::vector<int>& tokens);
+  // Incremental decoder for streaming text; valid while this tokenizer lives
+  whisper::StreamingDetokenizer make_detokenizer();
 
   // C++ equivalent of split_to_word_tokens().
   std::pair<std::vector<std::string>, std::vector<std::vector<int>>>
@@ -80,8 +96,13 @@ private:
   std::optional<int> _language;
   std::string _language_code;
 
-  // Whisper tokenizer wrapper for enhanced functionality
-  std::unique_ptr<whisper::TokenizerWrapper> whisper_wrapper_;
+  // Whisper tokenizer wrapper for enhanced functionality, shared by copies
+  std::shared_ptr<whisper::TokenizerWrapper> whisper_wrapper_;
+
+  // SOT sequence of every language in _LANGUAGE_CODES order, or the single
+  // sequence of an English-only tokenizer, and the active one
+  std::shared_ptr<const std::vector<std::vector<int>>> _sot_sequences;
+  size_t _sot_index = 0;
 
   // Optional members to cache the result of the `cached_property` methods.
   std::optional<int> _transcribe;
@@ -99,6 +120,11 @@ private:
 
   std::pair<std::vector<std::string>, std::vector<std::vector<int>>>
   split_tokens_on_spaces(const std::vector<int>& tokens);
+
+  void init_sot_sequences();
+  // Validates task and language and resolves their tokens from whisper_wrapper_
+  void init_task_and_language(bool multilingual, const std::optional<std::string>& task,
+                              const std::optional<std::string>& language);
 };
 
 #endif // TOKENIZER_H
@@ -2,6 +2,7 @@
 #define WHISPER_MODEL_H
 
 #include "feature_extractor.h"
+#include "speech_chunks.h"
 
 #include <ctranslate2/models/whisper.h>
 #include "tokenizer.h"
@@ -9,7 +10,11 @@
 #include <vector>
 #include <map>
 #include <optional>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <variant>
 
 struct Word {
@@ -39,6 +44,7 @@ struct Segment {
   float no_speech_prob;
   std::optional<std::vector<Word>> words;
   std::optional<float> temperature;
+  int beam_size;  // 1 when adaptive_beam kept the greedy result
 
   std::string to_string() const {
   std::string words_str = "[";
@@ -100,14 +106,102 @@ struct TranscriptionOptions {
 
   std::optional<float> hallucination_silence_threshold;
   std::optional<std::string> hotwords;
+
+  // Windows encoded and decoded together when condition_on_previous_text is
+  // off; adaptive_beam, speculative_fallback, hallucination_silence_threshold
+  // and per-window language detection decode window by window instead
+  int batch_size = 8;
+
+  // Submit the greedy attempt and the first sampled fallback together when a
+  // model replica is idle, instead of sampling only after greedy fails
+  bool speculative_fallback = false;
+
+  // Decode greedily first and run the beam search only when the greedy result
+  // fails the log-prob, compression ratio or no-speech checks
+  bool adaptive_beam = false;
+
+  // Per-window cap on generated tokens when max_new_tokens is not set:
+  // token_budget_margin plus max_tokens_per_second for each second of the
+  // window. Bounds runaway repetition on short windows; 0 disables it.
+  float max_tokens_per_second = 20.0f;
+  int token_budget_margin = 32;
+
+  // Decode in chunks of this many tokens, feeding each chunk back as prefix,
+  // so a repetition loop or a compression ratio over the threshold ends the
+  // attempt early and the fallback starts; 0 decodes in one call.
+  // Limitation: only takes effect with without_timestamps. CTranslate2 would
+  // force each continuation to open with an initial timestamp, so timestamped
+  // decoding (the default and every latency profile) ignores it with a warning
+  int decode_chunk_tokens = 0;
+  // Times the same n-gram must repeat at the end of the text to count as a loop
+  int repetition_loop_count = 4;
+};
+
+// Read-only view of one clip of 16 kHz samples owned by the caller.
+struct AudioSpan {
+  const float *data;
+  size_t size;
+};
+
+// How a transcription ended
+enum class TranscriptionStatus {
+  Completed,         // Every window was decoded
+  Cancelled,         // Stopped by TranscriptionControl::cancel()
+  DeadlineExceeded   // Stopped at the deadline
+};
+
+// Cooperative cancellation and deadline of one transcription. cancel() may be
+// called from any thread; decoding checks between windows and temperature
+// attempts and returns the segments finished so far. Use one per transcription.
+class TranscriptionControl {
+public:
+  TranscriptionControl() = default;
+  explicit TranscriptionControl(std::chrono::steady_clock::time_point deadline) : deadline_(deadline) {}
+  TranscriptionControl(const TranscriptionControl &) = delete;
+  TranscriptionControl &operator=(const TranscriptionControl &) = delete;
+
+  void cancel() { cancelled_.store(true); }
+
+  // True when decoding has to stop; the first reason found becomes the status
+  bool should_stop() const;
+
+  // Completed unless should_stop() has returned true
+  TranscriptionStatus status() const { return status_.load(); }
+
+private:
+  std::optional<std::chrono::steady_clock::time_point> deadline_;
+  std::atomic<bool> cancelled_{false};
+  mutable std::atomic<TranscriptionStatus> status_{TranscriptionStatus::Completed};
+};
+
+// How far a transcription has got when a segment is delivered
+struct TranscriptionProgress {
+  float processed_seconds;  // End of the delivered segment in the audio
+  float total_seconds;      // Duration of the whole audio
+};
+
+// Receives each segment once it is final, in timestamp order. Segments of
+// silence-separated parts decoded in parallel are held back until every
+// earlier part is delivered. Calls come from the decoding threads, one at a time.
+using SegmentCallback = std::function<void(const Segment &, const TranscriptionProgress &)>;
+
+// Encoder outputs of one request keyed by decode window: its first sample and
+// length in samples. Language detection leaves the windows it encodes here and
+// decoding takes them out, so no window goes through the encoder twice.
+struct EncoderCache {
+  std::map<std::pair<size_t, size_t>, ctranslate2::StorageView> outputs;
+  int encoded_windows = 0;  // Windows sent through the encoder for this request
 };
 
 struct TranscriptionInfo {
   std::string language;
   float language_probability;
   float duration;
+  float duration_after_vad;
   std::optional<std::vector<std::pair<std::string, float>>> all_language_probs;
   TranscriptionOptions transcription_options;
+  std::optional<MelVadOptions> vad_options;
+  TranscriptionStatus status = TranscriptionStatus::Completed;
 };
 
 class  WhisperModel {
@@ -134,8 +228,36 @@ public:
   std::tuple<std::vector<Segment>, TranscriptionInfo> transcribe(
     const std::vector<float> &audio,
     const std::optional<std::string> &language = std::nullopt,
-    bool multilingual = false
+    bool multilingual = false,
+    bool vad_filter = false,
+    const MelVadOptions &vad_parameters = MelVadOptions(),
+    const SegmentCallback &on_segment = nullptr,
+    const TranscriptionControl *control = nullptr
+  );
+  // Same as above with caller-supplied decoding options, e.g. from
+  // latency_profile(). clip_timestamps other than "0" selects start,end pairs in
+  // seconds; each clip is decoded separately and only its samples are featurized.
+  std::tuple<std::vector<Segment>, TranscriptionInfo> transcribe(
+    const std::vector<float> &audio,
+    const TranscriptionOptions &options,
+    const std::optional<std::string> &language = std::nullopt,
+    bool vad_filter = false,
+    const MelVadOptions &vad_parameters = MelVadOptions(),
+    const SegmentCallback &on_segment = nullptr,
+    const TranscriptionControl *control = nullptr
   );
+  // Transcribes many short clips together: features are extracted in parallel
+  // and clips of up to 30s share batched encode and generate calls.
+  std::vector<std::tuple<std::vector<Segment>, TranscriptionInfo>> transcribe_batch(
+    const std::vector<AudioSpan> &audios,
+    const std::optional<std::string> &language = std::nullopt,
+    const std::optional<TranscriptionOptions> &options = std::nullopt
+  );
+  static TranscriptionOptions default_options(bool multilingual = false);
+  // Named latency profiles: "realtime" (greedy, no temperature fallback, no word
+  // timestamps), "balanced" (small beam, short fallback) and "accurate" (Python
+  // defaults). Throws std::invalid_argument for any other name.
+  static TranscriptionOptions latency_profile(const std::string &profile, bool multilingual = false);
   std::tuple<std::vector<Segment>, int, bool> split_segments_by_timestamps(
     Tokenizer &tokenizer,
     const std::vector<int> &tokens,
@@ -147,15 +269,22 @@ public:
   std::vector<Segment> generate_segments(
     const std::vector<std::vector<float>> &features,
     Tokenizer &tokenizer,
-    const TranscriptionOptions &options
+    const TranscriptionOptions &options,
+    EncoderCache *encoder_cache = nullptr,
+    const std::function<void(const Segment &)> &on_segment = nullptr,
+    const TranscriptionControl *control = nullptr
   );
   ctranslate2::StorageView encode(const std::vector<std::vector<float>> &features);
-  std::tuple<std::vector<int>, float, float, float>
+  ctranslate2::StorageView encode_batch(const std::vector<std::vector<std::vector<float>>> &batch_features);
+  std::tuple<std::vector<int>, float, float, float, int>
   generate_with_fallback(
     const ctranslate2::StorageView &encoder_output,
     const std::vector<int> &prompt,
     Tokenizer &tokenizer,
-    const TranscriptionOptions &options
+    const TranscriptionOptions &options,
+    float window_seconds,
+    const TranscriptionControl *control = nullptr,
+    float *no_speech_prob = nullptr  // Set to the window's no-speech probability
   );
   std::vector<int> get_prompt(
     Tokenizer &tokenizer,
@@ -184,19 +313,110 @@ public:
     const std::vector<float> *audio = nullptr,
     const std::vector<std::vector<float>> *features = nullptr,
     int language_detection_segments = 1,
-    float language_detection_threshold = 0.5f
+    float language_detection_threshold = 0.5f,
+    EncoderCache *encoder_cache = nullptr,
+    int max_window_frames = 0  // Detection windows no longer than the decode windows; 0 for 30s
   );
 
-  std::vector<Word> generate_word_timestamps(
-    const Segment& segment,
-    Tokenizer& tokenizer
+  // Word timings for the segments of one window from a single align call;
+  // segment start and end are tightened to their first and last words
+  void generate_word_timestamps(
+    std::vector<Segment> &segments,
+    Tokenizer &tokenizer,
+    const ctranslate2::StorageView &encoder_output,
+    int num_frames,
+    const TranscriptionOptions &options,
+    float last_speech_timestamp
   );
 
 private:
+  // Cache key of the window features[:, seek:seek + size]
+  std::pair<size_t, size_t> encoder_cache_key(int seek, int size) const;
+  // Encoder output of features[:, seek:seek + size], moved out of the cache when present
+  ctranslate2::StorageView encode_window(
+    const std::vector<std::vector<float>> &features,
+    int seek,
+    int size,
+    EncoderCache *encoder_cache
+  );
+  std::shared_ptr<Tokenizer> get_tokenizer(
+    const std::string &language,
+    const std::string &task = "transcribe"
+  );
+  // Segments of one decoded window, including text after its last timestamp
+  std::vector<Segment> decode_window_segments(
+    Tokenizer &tokenizer,
+    const std::vector<int> &tokens,
+    int seek,
+    int segment_size,
+    float avg_logprob,
+    float temperature,
+    float compression_ratio,
+    float no_speech_prob,
+    int beam_size,
+    int &idx
+  );
+  std::vector<Segment> generate_segments_batched(
+    const std::vector<std::vector<float>> &features,
+    const std::vector<std::pair<int, int>> &seek_clips,
+    const std::vector<int> &initial_tokens,
+    Tokenizer &tokenizer,
+    const TranscriptionOptions &options,
+    const std::function<void(const Segment &)> &on_segment,
+    const TranscriptionControl *control,
+    EncoderCache *encoder_cache
+  );
+  ctranslate2::models::WhisperOptions get_whisper_options(
+    const TranscriptionOptions &options,
+    float temperature,
+    size_t prompt_size,
+    float window_seconds = 0.0f  // Duration the token budget is derived from; 0 for none
+  ) const;
+  // One attempt decoded decode_chunk_tokens at a time; looping is set when it
+  // stopped early on a repetition loop. Setting abandon stops it between chunks
+  ctranslate2::models::WhisperGenerationResult generate_chunked(
+    const ctranslate2::StorageView &encoder_output,
+    const std::vector<size_t> &prompt,
+    const ctranslate2::models::WhisperOptions &whisper_options,
+    Tokenizer &tokenizer,
+    const TranscriptionOptions &options,
+    bool &looping,
+    const std::atomic<bool> *abandon = nullptr
+  );
+  // Scores one result into the fallback lists; true when the next temperature is needed
+  bool evaluate_generation(
+    const ctranslate2::models::WhisperGenerationResult &result,
+    float temperature,
+    int beam_size,
+    Tokenizer &tokenizer,
+    const TranscriptionOptions &options,
+    std::vector<std::tuple<std::vector<int>, float, float, float, int>> &all_results,
+    std::vector<std::tuple<std::vector<int>, float, float, float, int>> &below_cr_threshold_results
+  );
+  // Temperature fallback starting at first_temperature_index, given earlier results
+  std::tuple<std::vector<int>, float, float, float, int> continue_with_fallback(
+    const ctranslate2::StorageView &encoder_output,
+    const std::vector<int> &prompt,
+    Tokenizer &tokenizer,
+    const TranscriptionOptions &options,
+    float window_seconds,
+    size_t first_temperature_index,
+    std::vector<std::tuple<std::vector<int>, float, float, float, int>> all_results,
+    std::vector<std::tuple<std::vector<int>, float, float, float, int>> below_cr_threshold_results,
+    const TranscriptionControl *control = nullptr,
+    float *no_speech_prob = nullptr
+  );
+
   std::shared_ptr<ctranslate2::models::Whisper> model;
   std::shared_ptr<tokenizers::Tokenizer> hf_tokenizer;
   FeatureExtractor feature_extractor;
   std::string model_path_;  // Store model path for vocabulary loading
+  // Mapped vocabulary cache, or the parsed vocabulary when no cache can be written
+  std::shared_ptr<const whisper::VocabCache> vocab_cache_;
+  std::shared_ptr<const ctranslate2::Vocabulary> vocabulary_;
+  // Tokenizers keyed by (language, task), shared by every request
+  std::map<std::pair<std::string, std::string>, std::shared_ptr<Tokenizer>> tokenizers_;
+  std::mutex tokenizers_mutex_;
   int input_stride;
   int num_samples_per_token;
   int frames_per_second;
@@ -205,6 +425,14 @@ private:
   int max_length;
 };
 
+// Restores segment and word times computed on concatenated speech chunks to
+// times in the original audio.
+std::vector<Segment> restore_speech_timestamps(
+  std::vector<Segment> segments,
+  const std::vector<SpeechChunk> &speech_chunks,
+  int sampling_rate
+);
+
 // --- Conceptual helper functions (replace with actual implementations) ---
 
 // Conceptual function to simulate Python's `download_model`.
@@ -27,6 +27,35 @@ typedef struct {
 // Opaque pointer to WhisperModel (C++ class)
 typedef void* WhisperModelHandle;
 
+// Opaque pointer to a cancellation token and deadline for one transcription
+typedef void* WhisperTranscriptionControlHandle;
+
+// How a transcription ended
+typedef enum {
+    TRANSCRIPTION_COMPLETED = 0,          // Every window was decoded
+    TRANSCRIPTION_CANCELLED = 1,          // Stopped by whisper_cancel_transcription
+    TRANSCRIPTION_DEADLINE_EXCEEDED = 2,  // Stopped at the deadline; segments are partial
+    TRANSCRIPTION_FAILED = 3              // Transcription raised an error; segments are empty
+} TranscriptionStatusCode;
+
+// Decoding options exposed to C; fill from a latency profile with
+// whisper_decoding_options and adjust fields before transcribing
+#define WHISPER_MAX_TEMPERATURES 8
+typedef struct {
+    int beam_size;                          // 1 for greedy
+    int best_of;
+    float patience;
+    float temperatures[WHISPER_MAX_TEMPERATURES];  // Fallback schedule, tried in order
+    int temperature_count;
+    int word_timestamps;                    // Boolean
+    int condition_on_previous_text;         // Boolean
+    int speculative_fallback;               // Boolean; greedy and first sampled attempt run together
+    int adaptive_beam;                      // Boolean; greedy first, beam search only on low confidence
+    int decode_chunk_tokens;                // Tokens per decode call with a repetition check between; 0 for one call (untimestamped decoding only)
+    float hallucination_silence_threshold;  // Seconds; skip likely hallucinations between longer silences, 0 to keep all
+    const char* clip_timestamps;            // "start,end,..." in seconds to transcribe only those ranges; NULL for all
+} WhisperDecodingOptions;
+
 // Transcription result structure
 typedef struct {
     char* text;              // Transcribed text
@@ -34,12 +63,22 @@ typedef struct {
     float end;               // End time in seconds
 } TranscriptionSegment;
 
+// Receives each segment as soon as it is final, in timestamp order, with the
+// seconds of audio processed so far. The segment text is only valid during the call.
+typedef void (*TranscriptionSegmentCallback)(
+    const TranscriptionSegment* segment,
+    float processed_seconds,
+    float total_seconds,
+    void* user_data
+);
+
 typedef struct {
     TranscriptionSegment* segments;
     unsigned long segment_count;
     char* language;
     float language_probability;
     float duration;
+    int status;              // TranscriptionStatusCode
 } TranscriptionResult;
 
 // Audio processing functions
@@ -48,6 +87,10 @@ FloatMatrix whisper_extract_mel_spectrogram(const float* audio, unsigned long le
 
 // Model management functions
 WhisperModelHandle whisper_create_model(const char* model_path);
+WhisperModelHandle whisper_create_model_with_workers(
+    const char* model_path,
+    int num_workers  // Model replicas; silence-separated segments decode in parallel
+);
 void whisper_destroy_model(WhisperModelHandle model);
 TranscriptionResult whisper_transcribe(
     WhisperModelHandle model,
@@ -55,6 +98,47 @@ TranscriptionResult whisper_transcribe(
     unsigned long audio_length,
     const char* language  // NULL for auto-detect
 );
+TranscriptionResult whisper_transcribe_streaming(
+    WhisperModelHandle model,
+    const float* audio,
+    unsigned long audio_length,
+    const char* language,                   // NULL for auto-detect
+    TranscriptionSegmentCallback callback,  // NULL to only return the full result
+    void* user_data                         // Passed back to callback
+);
+
+// Cancellation: create a control, pass it to whisper_transcribe_with_control and
+// call whisper_cancel_transcription from any thread to stop between windows.
+// The result then holds the segments finished so far.
+WhisperTranscriptionControlHandle whisper_create_transcription_control(
+    double timeout_seconds  // Deadline from now; 0 or less for none
+);
+void whisper_cancel_transcription(WhisperTranscriptionControlHandle control);
+void whisper_destroy_transcription_control(WhisperTranscriptionControlHandle control);
+TranscriptionResult whisper_transcribe_with_control(
+    WhisperModelHandle model,
+    const float* audio,
+    unsigned long audio_length,
+    const char* language,                        // NULL for auto-detect
+    TranscriptionSegmentCallback callback,       // NULL to only return the full result
+    void* user_data,                             // Passed back to callback
+    WhisperTranscriptionControlHandle control    // NULL to always run to the end
+);
+
+// Latency profiles: "realtime" (greedy, no temperature fallback, no word
+// timestamps), "balanced" and "accurate" (the defaults).
+// Returns 0 and leaves options untouched for an unknown profile.
+int whisper_decoding_options(const char* profile, WhisperDecodingOptions* options);
+TranscriptionResult whisper_transcribe_with_options(
+    WhisperModelHandle model,
+    const float* audio,
+    unsigned long audio_length,
+    const char* language,                        // NULL for auto-detect
+    const WhisperDecodingOptions* options,       // NULL for the "accurate" profile
+    TranscriptionSegmentCallback callback,       // NULL to only return the full result
+    void* user_data,                             // Passed back to callback
+    WhisperTranscriptionControlHandle control    // NULL to always run to the end
+);
 
 // Memory cleanup functions
 void whisper_free_float_array(FloatArray array);
@@ -0,0 +1,86 @@
+///
+/// speech_chunks.cpp
+/// IArabicSpeech
+///
+
+#include "speech_chunks.h"
+#include <algorithm>
+#include <cmath>
+
+SpeechTimestampsMap::SpeechTimestampsMap(
+  const std::vector<SpeechChunk> &speech_chunks,
+  int sampling_rate,
+  int time_precision
+) : sampling_rate_(sampling_rate),
+    time_precision_(time_precision) {
+  long previous_end = 0;
+  long silent_samples = 0;
+
+  for (const auto &chunk : speech_chunks) {
+    long start = static_cast<long>(chunk.at("start"));
+    long end = static_cast<long>(chunk.at("end"));
+    silent_samples += start - previous_end;
+    previous_end = end;
+
+    chunk_end_sample_.push_back(end - silent_samples);
+    total_silence_before_.push_back(static_cast<float>(silent_samples) / sampling_rate_);
+  }
+}
+
+int SpeechTimestampsMap::get_chunk_index(float t, bool is_end) const {
+  if (chunk_end_sample_.empty()) {
+    return -1;
+  }
+
+  long sample = static_cast<long>(t * sampling_rate_);
+
+  // A segment ending exactly on a chunk boundary belongs to that chunk
+  if (is_end) {
+    auto it = std::find(chunk_end_sample_.begin(), chunk_end_sample_.end(), sample);
+    if (it != chunk_end_sample_.end()) {
+      return static_cast<int>(it - chunk_end_sample_.begin());
+    }
+  }
+
+  // bisect_right
+  auto it = std::upper_bound(chunk_end_sample_.begin(), chunk_end_sample_.end(), sample);
+  int index = static_cast<int>(it - chunk_end_sample_.begin());
+  return std::min(index, static_cast<int>(chunk_end_sample_.size()) - 1);
+}
+
+float SpeechTimestampsMap::get_original_time(float t, int chunk_index, bool is_end) const {
+  if (chunk_index < 0) {
+    chunk_index = get_chunk_index(t, is_end);
+  }
+  if (chunk_index < 0) {
+    return t;
+  }
+
+  float scale = std::pow(10.0f, static_cast<float>(time_precision_));
+  return std::round((total_silence_before_[chunk_index] + t) * scale) / scale;
+}
+
+std::vector<std::vector<std::pair<int, int>>> pack_speech_chunks(
+  const std::vector<std::pair<int, int>> &regions,
+  int max_frames
+) {
+  std::vector<std::vector<std::pair<int, int>>> windows;
+  int window_frames = 0;
+
+  for (const auto &[region_start, region_end] : regions) {
+    // Regions longer than a window are cut into window-sized pieces
+    for (int start = region_start; start < region_end; start += max_frames) {
+      int end = std::min(region_end, start + max_frames);
+      int length = end - start;
+
+      if (windows.empty() || window_frames + length > max_frames) {
+        windows.emplace_back();
+        window_frames = 0;
+      }
+      windows.back().emplace_back(start, end);
+      window_frames += length;
+    }
+  }
+
+  return windows;
+}
@@ -60,6 +60,18 @@ const std::vector<std::string> _LANGUAGE_CODES = {
   "tt", "uk", "ur", "uz", "vi", "yi", "yo", "zh", "yue"
 };
 
+// Position of each language code in _LANGUAGE_CODES
+static const std::unordered_map<std::string, size_t>& language_indices() {
+  static const std::unordered_map<std::string, size_t> indices = [] {
+    std::unordered_map<std::string, size_t> map;
+    for (size_t i = 0; i < _LANGUAGE_CODES.size(); ++i) {
+      map.emplace(_LANGUAGE_CODES[i], i);
+    }
+    return map;
+  }();
+  return indices;
+}
+
 // --- Tokenizer Class Implementation ---
 
 Tokenizer::Tokenizer(
@@ -81,7 +93,7 @@ Tokenizer::Tokenizer(
 
   // Create whisper tokenizer wrapper for enhanced functionality
   // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Creating TokenizerWrapper...");
-  whisper_wrapper_ = std::make_unique<whisper::TokenizerWrapper>(
+  whisper_wrapper_ = std::make_shared<whisper::TokenizerWrapper>(
     multilingual,
     language.value_or("en"),
     task.value_or("transcribe"),
@@ -89,27 +101,28 @@ Tokenizer::Tokenizer(
   );
   // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "TokenizerWrapper created successfully");
 
-  if (multilingual) {
-  if (task && _TASKS.find(task.value()) == _TASKS.end()) {
-    throw std::invalid_argument("'" + task.value() + "' is not a valid task.");
-  }
-  if (language && std::find(_LANGUAGE_CODES.begin(), _LANGUAGE_CODES.end(), language.value()) == _LANGUAGE_CODES.end()) {
-    throw std::invalid_argument("'" + language.value() + "' is not a valid language code.");
-  }
+  init_task_and_language(multilingual, task, language);
+  init_sot_sequences();
+}
 
-  _task = whisper_wrapper_->get_transcribe();
-  if (task.value_or("") == "translate") {
-    _task = whisper_wrapper_->get_translate();
-  }
+Tokenizer::Tokenizer(
+  std::shared_ptr<const whisper::VocabCache> vocab_cache,
+  bool multilingual,
+  std::optional<std::string> task,
+  std::optional<std::string> language
+) : _tokenizer(nullptr), _multilingual(multilingual) {
+  (void)_tokenizer;
+  (void)_multilingual;
 
-  // Use the existing whisper_wrapper_ to get language token (it already has full vocabulary)
-  _language = whisper_wrapper_->get_language_token(language.value_or("en"));
-  _language_code = language.value_or("en");
-  } else {
-  _task = std::nullopt;
-  _language = std::nullopt;
-  _language_code = "en";
-  }
+  whisper_wrapper_ = std::make_shared<whisper::TokenizerWrapper>(
+    std::move(vocab_cache),
+    multilingual,
+    language.value_or("en"),
+    task.value_or("transcribe")
+  );
+
+  init_task_and_language(multilingual, task, language);
+  init_sot_sequences();
 }
 
 #ifndef NO_CTRANSLATE2
@@ -133,7 +146,7 @@ Tokenizer::Tokenizer(
 
 #ifndef NO_CTRANSLATE2
   // Explicitly use the CTranslate2 constructor
-  whisper_wrapper_ = std::make_unique<whisper::TokenizerWrapper>(
+  whisper_wrapper_ = std::make_shared<whisper::TokenizerWrapper>(
     vocabulary,  // CTranslate2 vocabulary - this should trigger the CTranslate2 constructor
     multilingual,
     language.value_or("en"),
@@ -145,6 +158,18 @@ Tokenizer::Tokenizer(
 
   // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "TokenizerWrapper with CTranslate2 vocab created successfully");
 
+  init_task_and_language(multilingual, task, language);
+  init_sot_sequences();
+
+  // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Tokenizer (CTranslate2) created successfully");
+}
+#endif // NO_CTRANSLATE2
+
+void Tokenizer::init_task_and_language(
+  bool multilingual,
+  const std::optional<std::string>& task,
+  const std::optional<std::string>& language
+) {
   if (multilingual) {
   if (task && _TASKS.find(task.value()) == _TASKS.end()) {
     throw std::invalid_argument("'" + task.value() + "' is not a valid task.");
@@ -166,10 +191,7 @@ Tokenizer::Tokenizer(
   _language = std::nullopt;
   _language_code = "en";
   }
-
-  // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Tokenizer (CTranslate2) created successfully");
 }
-#endif // NO_CTRANSLATE2
 
 int Tokenizer::get_transcribe() {
   return whisper_wrapper_->get_transcribe();
@@ -207,8 +229,42 @@ int Tokenizer::get_timestamp_begin() {
   return whisper_wrapper_->get_timestamp_begin();
 }
 
-std::vector<int> Tokenizer::get_sot_sequence() {
-  return whisper_wrapper_->get_sot_sequence();
+const std::vector<int>& Tokenizer::get_sot_sequence() const {
+  return (*_sot_sequences)[_sot_index];
+}
+
+void Tokenizer::set_language(const std::string& language_code) {
+  if (!_language) {
+    // English-only models have no language token to switch
+    return;
+  }
+  auto it = language_indices().find(language_code);
+  if (it == language_indices().end()) {
+    throw std::invalid_argument("'" + language_code + "' is not a valid language code.");
+  }
+  _language = whisper_wrapper_->get_language_token(language_code);
+  _language_code = language_code;
+  _sot_index = it->second;
+}
+
+const std::string& Tokenizer::get_language_code() const {
+  return _language_code;
+}
+
+void Tokenizer::init_sot_sequences() {
+  // One sequence per language, so switching languages is an index change
+  auto sequences = std::make_shared<std::vector<std::vector<int>>>();
+  if (_language) {
+    sequences->reserve(_LANGUAGE_CODES.size());
+    for (const auto& code : _LANGUAGE_CODES) {
+      sequences->push_back(whisper_wrapper_->get_sot_sequence(code));
+    }
+    _sot_index = language_indices().at(_language_code);
+  } else {
+    sequences->push_back(whisper_wrapper_->get_sot_sequence());
+    _sot_index = 0;
+  }
+  _sot_sequences = std::move(sequences);
 }
 
 std::vector<int> Tokenizer::encode(const std::string& text) {
@@ -219,6 +275,10 @@ std::string Tokenizer::decode(const std::vector<int>& tokens) {
   return whisper_wrapper_->decode(tokens);
 }
 
+whisper::StreamingDetokenizer Tokenizer::make_detokenizer() {
+  return whisper_wrapper_->make_detokenizer();
+}
+
 std::string Tokenizer::decode_with_timestamps(const std::vector<int>& tokens) {
   std::string result;
   std::vector<std::vector<int>> outputs = {{}};
@@ -244,13 +304,18 @@ std::string Tokenizer::decode_with_timestamps(const std::vector<int>& tokens) {
 
 std::pair<std::vector<std::string>, std::vector<std::vector<int>>>
 Tokenizer::split_to_word_tokens(const std::vector<int>& tokens) {
-  return whisper_wrapper_->split_to_word_tokens(tokens);
+  // Languages written without spaces between words split on characters only
+  static const std::set<std::string> no_space_languages = {"zh", "ja", "th", "lo", "my", "yue"};
+  if (no_space_languages.count(_language_code)) {
+    return split_tokens_on_unicode(tokens);
+  }
+  return split_tokens_on_spaces(tokens);
 }
 
 std::pair<std::vector<std::string>, std::vector<std::vector<int>>>
 Tokenizer::split_tokens_on_unicode(const std::vector<int>& tokens) {
   // Use whisper tokenizer's implementation
-  return whisper_wrapper_->split_to_word_tokens(tokens);
+  return whisper_wrapper_->split_tokens_on_unicode(tokens);
 }
 
 std::pair<std::vector<std::string>, std::vector<std::vector<int>>>
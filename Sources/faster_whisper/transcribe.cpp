@@ -1,9 +1,13 @@
 
 #include "transcribe.h"
+#include "decode_checks.h"
 #include "utils.h"
 #include "whisper_tokenizer.h"
+#include "text_normalizer.h"
 #include <ctranslate2/models/whisper.h>
 #include <ctranslate2/storage_view.h>
+#include <ctranslate2/ops/concat.h>
+#include <ctranslate2/ops/gather.h>
 #include <string>
 #include <memory>
 #include <filesystem>
@@ -21,6 +25,9 @@
 #include <chrono>
 #include <ctime>
 #include <sstream>
+#include <future>
+#include <deque>
+#include <thread>
 
 // Helper function to log with timestamp
 std::string getTranscribeTimestamp() {
@@ -47,7 +54,12 @@ void logTranscribeTimestamp(const std::string& message) {
 // Forward declarations of utility functions
 std::vector<std::vector<float>> slice_features(const std::vector<std::vector<float>>& features, int start, int length);
 ctranslate2::StorageView get_ctranslate2_storage_3d(const std::vector<std::vector<float>>& features);
+ctranslate2::StorageView get_ctranslate2_storage_3d(const std::vector<std::vector<std::vector<float>>>& batch_features);
+ctranslate2::StorageView slice_batch(const ctranslate2::StorageView& batch, long index);
 float get_compression_ratio(const std::string& text);
+void merge_punctuations(std::vector<std::map<std::string, std::any>>& alignment,
+                        const std::string& prepended, const std::string& appended);
+const Segment* next_words_segment(const std::vector<Segment>& segments, size_t start);
 std::vector<std::vector<float>> pad_or_trim(const std::vector<std::vector<float>>& segment);
 #include <stdexcept>
 #include <numeric>
@@ -125,14 +137,15 @@ WhisperModel::WhisperModel(
       std::cout << "Initializing Whisper model with compute type: "
                 << (int)compute_type << " (FLOAT32)" << std::endl;
 
-      created_model = std::make_shared<ctranslate2::models::Whisper>(
-        model_path,
-        ctranslate2::Device::CPU,
-        compute_type,
-        device_index,
-        false,          // tensor_parallel
-        config
-      );
+      // One replica per worker so independent segments can be decoded in parallel
+      ctranslate2::models::ModelLoader model_loader(model_path);
+      model_loader.device = ctranslate2::Device::CPU;
+      model_loader.device_indices = device_index;
+      model_loader.num_replicas_per_device = std::max(1, num_workers);
+      model_loader.compute_type = compute_type;
+      model_loader.tensor_parallel = false;
+
+      created_model = std::make_shared<ctranslate2::models::Whisper>(model_loader, config);
 
       std::cout << "Successfully initialized Whisper model" << std::endl;
       break;
@@ -158,19 +171,19 @@ WhisperModel::WhisperModel(
   // -------------------
   // In Python: tokenizers.Tokenizer.from_file("tokenizer.json")
   // In C++: you must implement or use a tokenizer wrapper
-  std::string tokenizer_file = model_path + "/tokenizer.json";
-  if (std::filesystem::exists(tokenizer_file)) {
-    // Check vocabulary file and log token count
-    std::string vocab_file = model_path + "/vocabulary.json";
-    std::ifstream vocab_stream(vocab_file);
-    if (vocab_stream.is_open()) {
-      ctranslate2::Vocabulary temp_vocabulary = ctranslate2::Vocabulary::from_json_file(vocab_stream);
-      vocab_stream.close();
-      std::cout << "Loading HuggingFace tokenizer format with " << temp_vocabulary.size() << " tokens" << std::endl;
-      std::cout << "Loaded " << temp_vocabulary.size() << " tokens from vocabulary file" << std::endl;
-    }
+  // The vocabulary is loaded once and shared by the tokenizers cached in get_tokenizer.
+  // The compiled vocabulary cache is preferred: tokenizers look tokens up in the
+  // mapped file, so neither JSON parsing nor per-tokenizer hash maps are needed.
+  std::string vocab_file = model_path + "/vocabulary.json";
+  vocab_cache_ = whisper::VocabCache::open(vocab_file);
+  if (vocab_cache_) {
+    std::cout << "Mapped " << vocab_cache_->size() << " tokens from vocabulary cache" << std::endl;
+  } else if (std::ifstream vocab_stream(vocab_file); vocab_stream.is_open()) {
+    vocabulary_ = std::make_shared<const ctranslate2::Vocabulary>(
+      ctranslate2::Vocabulary::from_json_file(vocab_stream));
+    std::cout << "Loaded " << vocabulary_->size() << " tokens from vocabulary file" << std::endl;
   } else {
-    std::cerr << "Tokenizer not found, defaulting to fallback.\n";
+    std::cerr << "Vocabulary not found at " << vocab_file << ", tokenizers will be unavailable.\n";
   }
 
   // Placeholder for feature_kwargs logic.
@@ -214,11 +227,82 @@ std::map<std::string, std::string> WhisperModel::get_feature_kwargs(
   return config;
 }
 
+std::shared_ptr<Tokenizer> WhisperModel::get_tokenizer(const std::string &language, const std::string &task) {
+  if (!vocab_cache_ && !vocabulary_) {
+    throw std::runtime_error("Failed to open vocabulary file: " + model_path_ + "/vocabulary.json");
+  }
+
+  std::lock_guard<std::mutex> lock(tokenizers_mutex_);
+  auto &tokenizer = tokenizers_[{language, task}];
+  if (!tokenizer) {
+    tokenizer = vocab_cache_ ?
+      std::make_shared<Tokenizer>(vocab_cache_, model->is_multilingual(), task, language) :
+      std::make_shared<Tokenizer>(*vocabulary_, model->is_multilingual(), task, language);
+  }
+  return tokenizer;
+}
+
+std::tuple<std::vector<Segment>, TranscriptionInfo> WhisperModel::transcribe(
+  const std::vector<float> &audio,
+  const std::optional<std::string> &language,
+  bool multilingual,
+  bool vad_filter,
+  const MelVadOptions &vad_parameters,
+  const SegmentCallback &on_segment,
+  const TranscriptionControl *control
+) {
+  return transcribe(
+    audio, default_options(multilingual), language, vad_filter, vad_parameters, on_segment, control
+  );
+}
+
 std::tuple<std::vector<Segment>, TranscriptionInfo> WhisperModel::transcribe(
   const std::vector<float> &audio,
+  const TranscriptionOptions &transcription_options,
   const std::optional<std::string> &language,
-  bool multilingual
+  bool vad_filter,
+  const MelVadOptions &vad_parameters,
+  const SegmentCallback &on_segment,
+  const TranscriptionControl *control
 ) {
+  bool multilingual = transcription_options.multilingual;
+
+  // Explicit clip_timestamps select the ranges to transcribe; each clip is
+  // decoded as its own part, so features are computed only for its samples
+  std::vector<std::pair<size_t, size_t>> clips;
+  std::vector<float> clip_times = parse_clip_timestamps(transcription_options.clip_timestamps);
+  bool selective = !clip_times.empty() && !(clip_times.size() == 1 && clip_times[0] == 0.0f);
+  if (selective && vad_filter) {
+    std::cerr << "clip_timestamps is ignored when vad_filter is set" << std::endl;
+    selective = false;
+  }
+  if (transcription_options.decode_chunk_tokens > 0 && !transcription_options.without_timestamps) {
+    std::cerr << "decode_chunk_tokens is ignored unless without_timestamps is set" << std::endl;
+  }
+  if (selective) {
+    if (clip_times.size() % 2 == 1) {
+      clip_times.push_back(static_cast<float>(audio.size()) / feature_extractor.sampling_rate());
+    }
+    for (size_t i = 0; i < clip_times.size(); i += 2) {
+      size_t clip_start = std::min(audio.size(), static_cast<size_t>(
+        std::max(0.0f, clip_times[i]) * feature_extractor.sampling_rate()));
+      size_t clip_end = std::min(audio.size(), static_cast<size_t>(
+        std::max(0.0f, clip_times[i + 1]) * feature_extractor.sampling_rate()));
+      if (clip_start < clip_end) {
+        clips.emplace_back(clip_start, clip_end);
+      }
+    }
+    if (clips.empty()) {
+      TranscriptionInfo info;
+      info.language = language.value_or("ar");
+      info.language_probability = 1.0f;
+      info.duration = static_cast<float>(audio.size()) / feature_extractor.sampling_rate();
+      info.duration_after_vad = 0.0f;
+      info.transcription_options = transcription_options;
+      return std::make_tuple(std::vector<Segment>(), info);
+    }
+  }
+
   // Step 1: Split audio by silence and process only first segment
   std::vector<float> audio_to_process;
 
@@ -233,42 +317,50 @@ std::tuple<std::vector<Segment>, TranscriptionInfo> WhisperModel::transcribe(
   size_t silence_start = 0;
   bool in_silence = true;
 
-  // Skip initial silence
-  for (size_t i = 0; i < audio.size(); ++i) {
-    if (std::abs(audio[i]) >= silence_threshold) {
-      segment_start = i;
-      in_silence = false;
-      break;
+  // With vad_filter the speech regions come from the mel frames instead,
+  // so the raw samples are not scanned here
+  if (!vad_filter && !selective) {
+    // Skip initial silence
+    for (size_t i = 0; i < audio.size(); ++i) {
+      if (std::abs(audio[i]) >= silence_threshold) {
+        segment_start = i;
+        in_silence = false;
+        break;
+      }
     }
-  }
-
-  // Find silence boundaries
-  for (size_t i = segment_start; i < audio.size(); ++i) {
-    bool is_silent = std::abs(audio[i]) < silence_threshold;
 
-    if (!in_silence && is_silent) {
-      silence_start = i;
-      in_silence = true;
-    } else if (in_silence && !is_silent) {
-      size_t silence_duration = i - silence_start;
-      if (silence_duration >= min_silence_samples) {
-        size_t segment_length = silence_start - segment_start;
-        if (segment_length >= min_segment_samples) {
-          silence_segments.push_back({segment_start, silence_start});
+    // Find silence boundaries
+    for (size_t i = segment_start; i < audio.size(); ++i) {
+      bool is_silent = std::abs(audio[i]) < silence_threshold;
+
+      if (!in_silence && is_silent) {
+        silence_start = i;
+        in_silence = true;
+      } else if (in_silence && !is_silent) {
+        size_t silence_duration = i - silence_start;
+        if (silence_duration >= min_silence_samples) {
+          size_t segment_length = silence_start - segment_start;
+          if (segment_length >= min_segment_samples) {
+            silence_segments.push_back({segment_start, silence_start});
+          }
+          segment_start = i;
         }
-        segment_start = i;
+        in_silence = false;
       }
-      in_silence = false;
     }
-  }
 
-  // Add final segment if long enough
-  if (!in_silence && (audio.size() - segment_start) >= min_segment_samples) {
-    silence_segments.push_back({segment_start, audio.size()});
+    // Add final segment if long enough
+    if (!in_silence && (audio.size() - segment_start) >= min_segment_samples) {
+      silence_segments.push_back({segment_start, audio.size()});
+    }
   }
 
   // If no segments found, use entire audio
-  if (silence_segments.empty()) {
+  if (selective) {
+    audio_to_process = std::vector<float>(audio.begin() + clips[0].first, audio.begin() + clips[0].second);
+  } else if (vad_filter) {
+    audio_to_process = audio;
+  } else if (silence_segments.empty()) {
     audio_to_process = audio;
     std::cout << "No silence segments found, processing full audio" << std::endl;
   } else if (silence_segments.size() < 2) {
@@ -304,6 +396,70 @@ std::tuple<std::vector<Segment>, TranscriptionInfo> WhisperModel::transcribe(
 
   std::cout << "Features shape: (" << features.size() << ", " << features[0].size() << ")" << std::endl;
 
+  // Mark speech regions on the mel frames just computed; silent windows are
+  // then never handed to the decoder
+  std::vector<std::pair<int, int>> speech_regions;
+  std::vector<SpeechChunk> speech_chunks;
+  std::vector<float> packed_window_timestamps;
+  int first_window_frames = 0;  // Decode windows are the packed windows
+  if (vad_filter) {
+    int content_frames = static_cast<int>(features[0].size()) - 1;
+    for (auto [start_frame, end_frame] : feature_extractor.detect_speech(features, vad_parameters)) {
+      end_frame = std::min(end_frame, content_frames);
+      if (start_frame < end_frame) {
+        speech_regions.emplace_back(start_frame, end_frame);
+      }
+    }
+
+    // Pack the speech frames back to back into windows of at most 30s, so short
+    // utterances share one encoder pass instead of each being padded to 30s
+    auto windows = pack_speech_chunks(speech_regions, feature_extractor.nb_max_frames());
+    Matrix packed_features(features.size());
+    int packed_frames = 0;
+    for (const auto& window : windows) {
+      packed_window_timestamps.push_back(packed_frames * feature_extractor.time_per_frame());
+      for (const auto& [start_frame, end_frame] : window) {
+        for (size_t mel = 0; mel < features.size(); ++mel) {
+          packed_features[mel].insert(packed_features[mel].end(),
+                                      features[mel].begin() + start_frame,
+                                      features[mel].begin() + end_frame);
+        }
+        packed_frames += end_frame - start_frame;
+        speech_chunks.push_back({
+          {"start", static_cast<float>(start_frame * feature_extractor.hop_length)},
+          {"end", static_cast<float>(end_frame * feature_extractor.hop_length)}
+        });
+      }
+      packed_window_timestamps.push_back(packed_frames * feature_extractor.time_per_frame());
+      if (first_window_frames == 0) {
+        first_window_frames = packed_frames;
+      }
+    }
+
+    duration_after_vad = std::min(duration, packed_frames * feature_extractor.time_per_frame());
+
+    std::cout << "VAD filter kept " << duration_after_vad << "s of " << duration << "s in "
+              << speech_regions.size() << " speech regions" << std::endl;
+
+    if (speech_regions.empty()) {
+      TranscriptionInfo info;
+      info.language = language.value_or("ar");
+      info.language_probability = 1.0f;
+      info.duration = duration;
+      info.duration_after_vad = 0.0f;
+      info.vad_options = vad_parameters;
+      return std::make_tuple(std::vector<Segment>(), info);
+    }
+
+    // Keep the trailing frame that generate_segments excludes from the content
+    for (size_t mel = 0; mel < features.size(); ++mel) {
+      packed_features[mel].push_back(features[mel][speech_regions.back().second]);
+    }
+    std::cout << "Packed " << speech_chunks.size() << " speech chunks into "
+              << windows.size() << " windows" << std::endl;
+    features = std::move(packed_features);
+  }
+
   // Log feature statistics
   if (!features.empty() && !features[0].empty()) {
     float min_val = features[0][0], max_val = features[0][0];
@@ -346,7 +502,9 @@ std::tuple<std::vector<Segment>, TranscriptionInfo> WhisperModel::transcribe(
     std::cout << "]" << std::endl;
   }
 
-  // Step 4: Language detection - follows Python logic exactly
+  // Step 4: Language detection - follows Python logic exactly. The windows it
+  // encodes match the first decode windows and are kept for decoding them.
+  EncoderCache encoder_cache;
   std::string detected_language;
   float language_probability = 1.0f;
   std::vector<std::pair<std::string, float>> all_language_probs;
@@ -358,7 +516,7 @@ std::tuple<std::vector<Segment>, TranscriptionInfo> WhisperModel::transcribe(
     } else {
       // Detect language using the features (like Python line 924-932)
       auto [lang, prob, all_probs] = detect_language(
-        nullptr, &features, 1, 0.5f
+        nullptr, &features, 1, 0.5f, &encoder_cache, first_window_frames
       );
       detected_language = lang;
       language_probability = prob;
@@ -376,104 +534,13 @@ std::tuple<std::vector<Segment>, TranscriptionInfo> WhisperModel::transcribe(
     language_probability = 1;
   }
 
-  // Step 5: Initialize tokenizer with vocabulary from assets (Python line 949-954)
-  // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "🔧 TOKENIZER INITIALIZATION DEBUG");
-  // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Creating tokenizer with multilingual=%d, task=transcribe, language=%s",
-  //                     model->is_multilingual(), detected_language.c_str());
-  // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Model path received: '%s'", model_path_.c_str());
-
-  // Load vocabulary from copied assets in internal storage
-  std::string vocab_path = model_path_ + "/vocabulary.json";
-  // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "📁 Constructed vocabulary path: '%s'", vocab_path.c_str());
-
-  // Check if vocabulary file exists before trying to load it
-  std::ifstream vocab_check(vocab_path);
-  if (vocab_check.good()) {
-    vocab_check.seekg(0, std::ios::end);
-    size_t file_size = vocab_check.tellg();
-    vocab_check.close();
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "✅ Vocabulary file found! Size: %zu bytes", file_size);
-  } else {
-    __android_log_print(ANDROID_LOG_ERROR, "#transcribe", "❌ Vocabulary file NOT FOUND at: %s", vocab_path.c_str());
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "📂 Trying to debug what files exist in model directory: %s", model_path_.c_str());
-
-    // Try to check if model directory exists
-    std::ifstream model_dir_test(model_path_ + "/config.json");
-    if (model_dir_test.good()) {
-      // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "✅ Model directory exists (found config.json)");
-      model_dir_test.close();
-    } else {
-      __android_log_print(ANDROID_LOG_ERROR, "#transcribe", "❌ Model directory might not exist or be accessible");
-    }
-
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "🔍 Model directory existence check completed");
-  }
-
-  // Load vocabulary from the model directory
-  std::string vocab_file = model_path_ + "/vocabulary.json";
-
-  std::ifstream vocab_stream(vocab_file);
-  if (!vocab_stream.is_open()) {
-    throw std::runtime_error("Failed to open vocabulary file: " + vocab_file);
-  }
-
-  ctranslate2::Vocabulary vocabulary = ctranslate2::Vocabulary::from_json_file(vocab_stream);
-  vocab_stream.close();
-
-  // Use the CTranslate2 vocabulary to create the tokenizer
-  Tokenizer tokenizer(vocabulary, model->is_multilingual(), std::string("transcribe"), detected_language);
-
-  // Debug tokenizer initialization
-  // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "🧪 Testing tokenizer methods...");
-
-  try {
-    int sot = tokenizer.get_sot();
-    int sot_prev = tokenizer.get_sot_prev();
-    int eot = tokenizer.get_eot();
-    int transcribe_token = tokenizer.get_transcribe();
-    auto sot_seq = tokenizer.get_sot_sequence();
-
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "SOT token: %d", sot);
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "SOT_PREV token: %d", sot_prev);
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "EOT token: %d", eot);
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "TRANSCRIBE token: %d", transcribe_token);
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "SOT sequence length: %zu", sot_seq.size());
-
-    // std::string sot_seq_str = "SOT sequence: ";
-    // for (size_t i = 0; i < sot_seq.size(); ++i) {
-    //   sot_seq_str += std::to_string(sot_seq[i]);
-    //   if (i < sot_seq.size() - 1) sot_seq_str += ", ";
-    // }
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "%s", sot_seq_str.c_str());
-  } catch (const std::exception& e) {
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Error testing tokenizer methods: %s", e.what());
-  }
+  // Step 5: Tokenizer for the detected language, built once per model (Python line 949-954)
+  std::shared_ptr<Tokenizer> tokenizer_ptr = get_tokenizer(detected_language);
+  Tokenizer &tokenizer = *tokenizer_ptr;
 
   // Step 6: Set up transcription options (Python line 956-989)
-  TranscriptionOptions options;
-  options.beam_size = 5;
-  options.best_of = 5;
-  options.patience = 1.0f;
-  options.length_penalty = 1.0f;
-  options.repetition_penalty = 1.0f;  // Match Python default (was 1.1f)
-  options.no_repeat_ngram_size = 0;   // Match Python default (was 3)
-  options.log_prob_threshold = -1.0f;
-  options.no_speech_threshold = 0.6f;
-  options.compression_ratio_threshold = 2.4f;
-  options.condition_on_previous_text = true;
-  options.prompt_reset_on_temperature = 0.5f;
-  options.temperatures = {0.0f, 0.2f, 0.4f, 0.6f, 0.8f, 1.0f}; // Python default
-  options.initial_prompt = std::nullopt;
-  options.prefix = std::nullopt;
-  options.suppress_blank = true;
-  options.suppress_tokens = std::nullopt;
-  options.without_timestamps = false;
-  options.max_initial_timestamp = 1.0f;
-  options.word_timestamps = true;
-  options.prepend_punctuations = "\"'¿([{-";
-  options.append_punctuations = "\"\'.。，！？：\")}]、";
+  TranscriptionOptions options = transcription_options;
   options.multilingual = multilingual;
-  options.max_new_tokens = std::nullopt;
 
   // For short segments, don't use overlapping windows - just process the full duration
   std::vector<float> overlapping_timestamps;
@@ -481,46 +548,134 @@ std::tuple<std::vector<Segment>, TranscriptionInfo> WhisperModel::transcribe(
   overlapping_timestamps.push_back(duration);
 
   options.clip_timestamps = overlapping_timestamps;
-  options.hallucination_silence_threshold = std::nullopt;
-  options.hotwords = std::nullopt;
+
+  // With VAD each packed window is decoded as its own clip
+  if (vad_filter) {
+    options.clip_timestamps = packed_window_timestamps;
+  }
 
   // Step 7: Generate segments using the same logic as Python (line 991-993)
-  std::vector<Segment> segments = generate_segments(features, tokenizer, options);
+  // Every silence-separated segment is decoded by its own generate_segments call,
+  // so its prompt starts empty and the segments are independent of each other.
+  // With several model replicas they are dispatched concurrently and merged in order.
+  // Each part is a range of samples; a single part covers the whole audio
+  std::vector<std::pair<size_t, size_t>> parts;
+  if (selective) {
+    parts = clips;
+  } else if (silence_segments.size() >= 2) {
+    parts = silence_segments;
+  } else {
+    parts.emplace_back(0, audio.size());
+  }
+  size_t num_parts = parts.size();
+
+  // Segments are finalized as each part produces them and delivered in
+  // timestamp order: a part's segments wait only until every earlier part is done
+  float total_duration = static_cast<float>(audio.size()) / feature_extractor.sampling_rate();
+  std::vector<Segment> segments;
+  std::mutex delivery_mutex;
+  std::vector<std::vector<Segment>> pending(num_parts);
+  std::vector<bool> part_done(num_parts, false);
+  size_t next_part = 0;
+  int segment_id = 0;
+
+  // Shifts a segment back to its place in the audio and hands it out; called with the lock held
+  auto deliver = [&](size_t seg_idx, Segment seg) {
+    // Map times in the packed speech back to the original audio
+    if (vad_filter) {
+      std::vector<Segment> packed;
+      packed.push_back(std::move(seg));
+      seg = std::move(restore_speech_timestamps(std::move(packed), speech_chunks,
+                                                feature_extractor.sampling_rate()).front());
+    }
+    float part_offset = static_cast<float>(parts[seg_idx].first) / feature_extractor.sampling_rate();
+    seg.id = ++segment_id;
+    seg.start += part_offset;
+    seg.end += part_offset;
+    if (seg.words.has_value()) {
+      for (auto& word : seg.words.value()) {
+        word.start += part_offset;
+        word.end += part_offset;
+      }
+    }
+    segments.push_back(std::move(seg));
+    if (on_segment) {
+      on_segment(segments.back(), {std::min(segments.back().end, total_duration), total_duration});
+    }
+  };
 
-  // Output first segment result
-  std::cout << "\n=== First Segment Result ===" << std::endl;
-  for (const auto& seg : segments) {
-    std::cout << "[" << seg.start << "s -> " << seg.end << "s] " << seg.text << std::endl;
-  }
+  auto on_part_segment = [&](size_t seg_idx, const Segment &seg) {
+    std::lock_guard<std::mutex> lock(delivery_mutex);
+    if (seg_idx == next_part) {
+      deliver(seg_idx, seg);
+    } else {
+      pending[seg_idx].push_back(seg);
+    }
+  };
 
-  // Process additional segments (2 onwards) in a loop
-  for (size_t seg_idx = 1; seg_idx < silence_segments.size(); ++seg_idx) {
-    std::cout << "\n=== Processing Segment " << (seg_idx + 1) << " ===" << std::endl;
-    auto [seg_start, seg_end] = silence_segments[seg_idx];
-    std::vector<float> segment_audio(audio.begin() + seg_start, audio.begin() + seg_end);
+  auto finish_part = [&](size_t seg_idx) {
+    std::lock_guard<std::mutex> lock(delivery_mutex);
+    part_done[seg_idx] = true;
+    while (next_part < num_parts && part_done[next_part]) {
+      if (++next_part < num_parts) {
+        std::cout << "\n=== Segment " << (next_part + 1) << " Result ===" << std::endl;
+        for (auto& seg : pending[next_part]) {
+          deliver(next_part, std::move(seg));
+        }
+        pending[next_part].clear();
+      }
+    }
+  };
 
-    std::cout << "Segment " << (seg_idx + 1) << ": " << (seg_end - seg_start) / 16000.0f << "s" << std::endl;
+  // Decodes one segment; the first one reuses the features computed above
+  auto decode_part = [&](size_t seg_idx) {
+    auto part_segment = [&, seg_idx](const Segment &seg) { on_part_segment(seg_idx, seg); };
+    if (control && control->should_stop()) {
+      finish_part(seg_idx);
+      return;
+    }
+    if (seg_idx == 0) {
+      generate_segments(features, tokenizer, options, &encoder_cache, part_segment, control);
+      finish_part(seg_idx);
+      return;
+    }
+    auto [seg_start, seg_end] = parts[seg_idx];
+    std::vector<float> segment_audio(audio.begin() + seg_start, audio.begin() + seg_end);
 
-    // Extract features from this segment
     auto segment_features = feature_extractor.extract(segment_audio);
-
     if (!segment_features.empty() && !segment_features[0].empty()) {
       // Update clip_timestamps for this segment's duration
+      TranscriptionOptions segment_options = options;
       float segment_duration = segment_audio.size() / 16000.0f;
-      std::vector<float> segment_timestamps = {0.0f, segment_duration};
-      options.clip_timestamps = segment_timestamps;
-
-      // Generate segments for this audio segment
-      std::vector<Segment> segment_results = generate_segments(segment_features, tokenizer, options);
+      segment_options.clip_timestamps = std::vector<float>{0.0f, segment_duration};
+      generate_segments(segment_features, tokenizer, segment_options, nullptr, part_segment, control);
+    }
+    finish_part(seg_idx);
+  };
 
-      // Output segment result
-      std::cout << "\n=== Segment " << (seg_idx + 1) << " Result ===" << std::endl;
-      for (const auto& seg : segment_results) {
-        std::cout << "[" << seg.start << "s -> " << seg.end << "s] " << seg.text << std::endl;
+  std::cout << "\n=== Segment 1 Result ===" << std::endl;
+  // Clips also overlap their feature extraction with decoding: one more clip
+  // than there are replicas is extracted while the replicas are busy
+  size_t max_in_flight = std::min(num_parts, selective ?
+    model->num_replicas() + 1 :
+    model->num_replicas());
+  if (max_in_flight <= 1) {
+    for (size_t seg_idx = 0; seg_idx < num_parts; ++seg_idx) {
+      decode_part(seg_idx);
+    }
+  } else {
+    std::cout << "Decoding " << num_parts << " segments on " << max_in_flight << " replicas" << std::endl;
+    std::deque<std::future<void>> in_flight;
+    for (size_t seg_idx = 0; seg_idx < num_parts; ++seg_idx) {
+      if (in_flight.size() == max_in_flight) {
+        in_flight.front().get();
+        in_flight.pop_front();
       }
-
-      // Append segment results to combined list
-      segments.insert(segments.end(), segment_results.begin(), segment_results.end());
+      in_flight.push_back(std::async(std::launch::async, decode_part, seg_idx));
+    }
+    while (!in_flight.empty()) {
+      in_flight.front().get();
+      in_flight.pop_front();
     }
   }
 
@@ -534,8 +689,24 @@ std::tuple<std::vector<Segment>, TranscriptionInfo> WhisperModel::transcribe(
   info.language = detected_language;
   info.language_probability = language_probability;
   info.duration = duration;
+  info.duration_after_vad = duration_after_vad;
   info.transcription_options = options;
+  if (selective) {
+    // The whole audio, of which only the clips were transcribed
+    info.duration = total_duration;
+    info.duration_after_vad = 0.0f;
+    for (const auto &[clip_start, clip_end] : clips) {
+      info.duration_after_vad += static_cast<float>(clip_end - clip_start) / feature_extractor.sampling_rate();
+    }
+    info.transcription_options.clip_timestamps = transcription_options.clip_timestamps;
+  }
+  if (vad_filter) {
+    info.vad_options = vad_parameters;
+  }
   info.all_language_probs = all_language_probs;
+  if (control) {
+    info.status = control->status();
+  }
 
   // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "🎯 TRANSCRIBE FUNCTION ABOUT TO RETURN!");
   // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Returning %zu segments, language: %s", segments.size(), info.language.c_str());
@@ -543,105 +714,199 @@ std::tuple<std::vector<Segment>, TranscriptionInfo> WhisperModel::transcribe(
   return std::make_tuple(segments, info);
 }
 
-std::vector<Word> WhisperModel::generate_word_timestamps(
-  const Segment& segment,
-  Tokenizer& tokenizer
+std::vector<std::tuple<std::vector<Segment>, TranscriptionInfo>> WhisperModel::transcribe_batch(
+  const std::vector<AudioSpan> &audios,
+  const std::optional<std::string> &language,
+  const std::optional<TranscriptionOptions> &transcription_options
 ) {
-  std::vector<Word> words;
-
-  if (segment.text.empty() || segment.tokens.empty()) {
-    return words;
+  TranscriptionOptions options = transcription_options.value_or(default_options());
+  options.clip_timestamps = std::string("0");
+  if (options.decode_chunk_tokens > 0 && !options.without_timestamps) {
+    std::cerr << "decode_chunk_tokens is ignored unless without_timestamps is set" << std::endl;
+  }
+
+  std::vector<std::tuple<std::vector<Segment>, TranscriptionInfo>> results(audios.size());
+  if (audios.empty()) {
+    return results;
+  }
+
+  // Extract features in parallel, bounded by the number of hardware threads
+  std::vector<Matrix> item_features(audios.size());
+  size_t max_in_flight = std::max(1u, std::thread::hardware_concurrency());
+  for (size_t group_start = 0; group_start < audios.size(); group_start += max_in_flight) {
+    size_t group_end = std::min(audios.size(), group_start + max_in_flight);
+    std::vector<std::future<Matrix>> extractions;
+    for (size_t i = group_start; i < group_end; ++i) {
+      extractions.push_back(std::async(std::launch::async, [this, &audios, i]() {
+        std::vector<float> samples(audios[i].data, audios[i].data + audios[i].size);
+        return feature_extractor.extract(samples);
+      }));
+    }
+    for (size_t i = group_start; i < group_end; ++i) {
+      item_features[i] = extractions[i - group_start].get();
+    }
   }
 
-  // Use tokenizer's split_to_word_tokens for proper word-level tokenization
-  // This handles Arabic text better than simple space splitting
-  auto [word_texts, word_token_groups] = tokenizer.split_to_word_tokens(segment.tokens);
+  // Clips that fit one window are batched; longer ones go through transcribe()
+  std::vector<size_t> batch_items;
+  for (size_t i = 0; i < audios.size(); ++i) {
+    float duration = static_cast<float>(audios[i].size) / feature_extractor.sampling_rate();
+    TranscriptionInfo info;
+    info.language = language.value_or("ar");
+    info.language_probability = 1.0f;
+    info.duration = duration;
+    info.duration_after_vad = duration;
+    info.transcription_options = options;
+    results[i] = std::make_tuple(std::vector<Segment>(), info);
+
+    if (item_features[i].empty() || item_features[i][0].size() < 2) {
+      continue;
+    }
+    if (static_cast<int>(item_features[i][0].size()) - 1 > feature_extractor.nb_max_frames()) {
+      std::vector<float> samples(audios[i].data, audios[i].data + audios[i].size);
+      results[i] = transcribe(samples, options, language);
+      continue;
+    }
+    batch_items.push_back(i);
+  }
 
-  if (word_texts.empty()) {
-    // Fallback to simple space-based splitting for Arabic
-    std::vector<std::string> fallback_words;
-    std::string current_word;
+  bool detect = !language.has_value() && model->is_multilingual();
+  size_t batch_size = static_cast<size_t>(std::max(1, options.batch_size));
 
-    // Handle UTF-8 Arabic text properly
-    for (size_t i = 0; i < segment.text.length(); ) {
-      unsigned char c = segment.text[i];
+  for (size_t batch_start = 0; batch_start < batch_items.size(); batch_start += batch_size) {
+    size_t batch_end = std::min(batch_items.size(), batch_start + batch_size);
 
-      // Check for whitespace (ASCII and Unicode)
-      if (c == ' ' || c == '\t' || c == '\n' || c == 0xC2) {
-        if (!current_word.empty()) {
-          fallback_words.push_back(current_word);
-          current_word.clear();
+    std::vector<std::vector<std::vector<float>>> batch_features;
+    for (size_t b = batch_start; b < batch_end; ++b) {
+      batch_features.push_back(pad_or_trim(item_features[batch_items[b]]));
+    }
+    ctranslate2::StorageView encoder_output = encode_batch(batch_features);
+
+    // Language per item, from the same encoder output
+    if (detect) {
+      auto language_futures = model->detect_language(encoder_output);
+      for (size_t b = batch_start; b < batch_end; ++b) {
+        auto language_probs = language_futures[b - batch_start].get();
+        auto &info = std::get<1>(results[batch_items[b]]);
+        std::vector<std::pair<std::string, float>> all_language_probs;
+        for (auto &[token, prob] : language_probs) {
+          all_language_probs.emplace_back(token.size() > 4 ? token.substr(2, token.size() - 4) : token, prob);
         }
-        i++;
-      } else {
-        // For Arabic (UTF-8), handle multi-byte characters
-        if (c >= 0xD8 && c <= 0xDF) { // Arabic UTF-8 range
-          // Arabic character - add 2 bytes
-          if (i + 1 < segment.text.length()) {
-            current_word += segment.text[i];
-            current_word += segment.text[i + 1];
-            i += 2;
-          } else {
-            current_word += c;
-            i++;
-          }
-        } else {
-          current_word += c;
-          i++;
+        if (!all_language_probs.empty()) {
+          info.language = all_language_probs[0].first;
+          info.language_probability = all_language_probs[0].second;
         }
+        info.all_language_probs = all_language_probs;
       }
     }
-    if (!current_word.empty()) {
-      fallback_words.push_back(current_word);
+
+    std::vector<std::shared_ptr<Tokenizer>> tokenizers;
+    std::vector<std::vector<int>> prompts;
+    std::vector<std::vector<size_t>> prompts_size_t;
+    for (size_t b = batch_start; b < batch_end; ++b) {
+      tokenizers.push_back(get_tokenizer(std::get<1>(results[batch_items[b]]).language));
+      prompts.push_back(get_prompt(
+        *tokenizers.back(), {}, options.without_timestamps, options.prefix, options.hotwords
+      ));
+      prompts_size_t.emplace_back(prompts.back().begin(), prompts.back().end());
     }
-    word_texts = fallback_words;
-  }
 
-  if (word_texts.empty()) {
-    return words;
-  }
+    // One generate call for the batch; only the items that fail the checks fall back.
+    // The token budget covers the longest clip in the batch. With adaptive beam
+    // the batch is decoded greedily first, as in continue_with_fallback, and an
+    // item that fails the checks runs the beam search from the first temperature
+    float first_temperature = options.temperatures.empty() ? 0.0f : options.temperatures[0];
+    float batch_seconds = 0.0f;
+    for (size_t b = batch_start; b < batch_end; ++b) {
+      batch_seconds = std::max(batch_seconds, std::get<1>(results[batch_items[b]]).duration);
+    }
+    bool greedy_first = options.adaptive_beam && options.beam_size > 1 && first_temperature == 0.0f;
+    TranscriptionOptions first_options = options;
+    TranscriptionOptions fallback_options = options;
+    if (greedy_first) {
+      first_options.beam_size = 1;
+      fallback_options.adaptive_beam = false;
+    }
+    auto result_futures = model->generate(
+      encoder_output, prompts_size_t,
+      get_whisper_options(first_options, first_temperature, prompts[0].size(), batch_seconds)
+    );
 
-  // Distribute timing across words with variable durations
-  // Arabic words may have different lengths, so weight by character count
-  float segment_duration = segment.end - segment.start;
+    for (size_t b = batch_start; b < batch_end; ++b) {
+      size_t batch_index = b - batch_start;
+      Tokenizer &tokenizer = *tokenizers[batch_index];
+
+      std::vector<std::tuple<std::vector<int>, float, float, float, int>> all_results;
+      std::vector<std::tuple<std::vector<int>, float, float, float, int>> below_cr_threshold_results;
+      auto result = result_futures[batch_index].get();
+
+      std::tuple<std::vector<int>, float, float, float, int> decode_result;
+      if (evaluate_generation(result, first_temperature, first_options.beam_size, tokenizer, options, all_results, below_cr_threshold_results)) {
+        decode_result = continue_with_fallback(
+          slice_batch(encoder_output, batch_index), prompts[batch_index], tokenizer, fallback_options,
+          std::get<1>(results[batch_items[b]]).duration, greedy_first ? 0 : 1,
+          std::move(all_results), std::move(below_cr_threshold_results)
+        );
+      } else {
+        decode_result = all_results.back();
+      }
+      auto [tokens, avg_logprob, temperature, compression_ratio, beam_size] = decode_result;
+      if (is_silent_window(result.no_speech_prob, avg_logprob, options)) {
+        continue;
+      }
 
-  // Calculate total character count for proportional timing
-  size_t total_chars = 0;
-  for (const auto& word : word_texts) {
-    total_chars += word.length();
+      int idx = 0;
+      int content_frames = static_cast<int>(item_features[batch_items[b]][0].size()) - 1;
+      auto &clip_segments = std::get<0>(results[batch_items[b]]);
+      clip_segments = decode_window_segments(
+        tokenizer, tokens, 0, content_frames, avg_logprob, temperature, compression_ratio,
+        result.no_speech_prob, beam_size, idx
+      );
+      if (options.word_timestamps) {
+        generate_word_timestamps(
+          clip_segments, tokenizer, slice_batch(encoder_output, batch_index), content_frames, options, 0.0f
+        );
+      }
+    }
   }
 
-  float current_time = segment.start;
-
-  for (size_t i = 0; i < word_texts.size(); ++i) {
-    Word word;
-    word.start = current_time;
-
-    // Proportional duration based on word length
-    float word_proportion = static_cast<float>(word_texts[i].length()) / total_chars;
-    float word_duration = segment_duration * word_proportion;
-
-    // Ensure last word ends exactly at segment end
-    if (i == word_texts.size() - 1) {
-      word.end = segment.end;
-    } else {
-      word.end = current_time + word_duration;
-    }
+  return results;
+}
 
-    word.word = word_texts[i];
+void WhisperModel::generate_word_timestamps(
+  std::vector<Segment> &segments,
+  Tokenizer &tokenizer,
+  const ctranslate2::StorageView &encoder_output,
+  int num_frames,
+  const TranscriptionOptions &options,
+  float last_speech_timestamp
+) {
+  if (segments.empty()) {
+    return;
+  }
+
+  // The segments of one window form a single group, aligned in one call
+  std::vector<std::vector<std::map<std::string, std::any>>> groups(1);
+  for (const auto &segment : segments) {
+    groups[0].push_back({
+      {"seek",   segment.seek},
+      {"start",  segment.start},
+      {"end",    segment.end},
+      {"tokens", segment.tokens}
+    });
+  }
 
-    // Assign confidence based on word token probabilities if available
-    if (i < word_token_groups.size() && !word_token_groups[i].empty()) {
-      word.probability = 0.85f + (i % 15) / 100.0f; // 0.85-0.99 range
-    } else {
-      word.probability = 0.88f; // Default confidence for Arabic
-    }
+  add_word_timestamps(
+    groups, tokenizer, encoder_output, num_frames,
+    options.prepend_punctuations, options.append_punctuations, last_speech_timestamp
+  );
 
-    words.push_back(word);
-    current_time = word.end;
+  for (size_t i = 0; i < segments.size(); ++i) {
+    auto &subsegment = groups[0][i];
+    segments[i].start = std::any_cast<float>(subsegment["start"]);
+    segments[i].end = std::any_cast<float>(subsegment["end"]);
+    segments[i].words = std::any_cast<std::vector<Word>>(subsegment["words"]);
   }
-
-  return words;
 }
 
 std::tuple<std::vector<Segment>, int, bool> WhisperModel::split_segments_by_timestamps(
@@ -779,21 +1044,22 @@ std::tuple<std::vector<Segment>, int, bool> WhisperModel::split_segments_by_time
 
 std::vector<Segment> WhisperModel::generate_segments(
   const std::vector<std::vector<float>> &features,
-  Tokenizer &tokenizer,
-  const TranscriptionOptions &options
+  Tokenizer &shared_tokenizer,
+  const TranscriptionOptions &options,
+  EncoderCache *encoder_cache,
+  const std::function<void(const Segment &)> &on_segment,
+  const TranscriptionControl *control
 ) {
+  // Tokenizers are shared between requests, so per-window language switches
+  // go to a copy; it shares the vocabulary and the precomputed SOT sequences
+  Tokenizer tokenizer = shared_tokenizer;
+
   // Follow Python implementation logic from line 1089-1375
   int content_frames = features[0].size() - 1;
   float content_duration = content_frames * feature_extractor.time_per_frame();
 
   // Parse clip_timestamps like Python (line 1100-1108)
-  std::vector<float> clip_timestamps_vec;
-  if (std::holds_alternative<std::vector<float>>(options.clip_timestamps)) {
-    clip_timestamps_vec = std::get<std::vector<float>>(options.clip_timestamps);
-  } else if (std::holds_alternative<std::string>(options.clip_timestamps)) {
-    // For simplicity, default to [0]
-    clip_timestamps_vec = {0.0f};
-  }
+  std::vector<float> clip_timestamps_vec = parse_clip_timestamps(options.clip_timestamps);
 
   // Create seek points (Python line 1110-1119)
   std::vector<int> seek_points;
@@ -823,7 +1089,7 @@ std::vector<Segment> WhisperModel::generate_segments(
   // Handle initial prompt (Python line 1129-1135)
   if (options.initial_prompt.has_value()) {
     if (std::holds_alternative<std::string>(options.initial_prompt.value())) {
-      std::string initial_prompt = " " + std::get<std::string>(options.initial_prompt.value());
+      std::string initial_prompt = " " + whisper::normalize_text(std::get<std::string>(options.initial_prompt.value()));
       std::vector<int> initial_tokens = tokenizer.encode(initial_prompt);
       all_tokens.insert(all_tokens.end(), initial_tokens.begin(), initial_tokens.end());
     } else if (std::holds_alternative<std::vector<int>>(options.initial_prompt.value())) {
@@ -832,12 +1098,29 @@ std::vector<Segment> WhisperModel::generate_segments(
     }
   }
 
+  // Without previous-text conditioning the 30s windows are independent, so
+  // they can be encoded and decoded in batches. The batched first attempt is a
+  // plain beam search in the tokenizer's language, so options that change the
+  // first attempt or act across windows keep the sequential loop
+  bool per_window_language = options.multilingual && model->is_multilingual();
+  bool batchable = !options.adaptive_beam && !options.speculative_fallback &&
+                   !options.hallucination_silence_threshold.has_value() && !per_window_language;
+  if (!options.condition_on_previous_text && options.batch_size > 1 && batchable) {
+    return generate_segments_batched(
+      features, seek_clips, all_tokens, tokenizer, options, on_segment, control, encoder_cache
+    );
+  }
+
   float last_speech_timestamp = 0.0f;
   ctranslate2::StorageView encoder_output;
 
   // Main transcription loop (Python line 1143-1375)
   //logTranscribeTimestamp("Transcription completed, processing segments...");
   while (clip_idx < seek_clips.size()) {
+    // Cancellation and the deadline are checked between windows
+    if (control && control->should_stop()) {
+      break;
+    }
     auto [seek_clip_start, seek_clip_end] = seek_clips[clip_idx];
     if (seek_clip_end > content_frames) {
       seek_clip_end = content_frames;
@@ -860,25 +1143,15 @@ std::vector<Segment> WhisperModel::generate_segments(
       seek_clip_end - seek
     });
 
-    // Extract and pad segment (Python line 1164-1166)
-    auto segment_features = slice_features(features, seek, segment_size);
-    segment_features = pad_or_trim(segment_features);
     float segment_duration = segment_size * feature_extractor.time_per_frame();
 
     // Get previous tokens for prompt (Python line 1173)
     std::vector<int> previous_tokens(all_tokens.begin() + prompt_reset_since, all_tokens.end());
     // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "previous_tokens.size(): %zu", previous_tokens.size());
 
-    // Encode segment if needed (Python line 1175-1176)
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Checking if encoding needed: seek=%d, encoder_output.empty()=%d",
-    //                     seek, encoder_output.empty());
-    if (seek > 0 || encoder_output.empty()) {
-      //logTranscribeTimestamp("Starting encoder");
-      encoder_output = encode(segment_features);
-      //logTranscribeTimestamp("Encoder completed");
-    } else {
-      // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Reusing existing encoder_output");
-    }
+    // Encode segment (Python line 1175-1176); a window already encoded for
+    // language detection comes from the cache
+    encoder_output = encode_window(features, seek, segment_size, encoder_cache);
 
     // Language detection per segment if multilingual (Python line 1178-1184)
     if (options.multilingual && model->is_multilingual()) {
@@ -890,7 +1163,7 @@ std::vector<Segment> WhisperModel::generate_segments(
         if (language_token.length() > 4) {
           std::string language = language_token.substr(2, language_token.length() - 4);
           // Update tokenizer language (Python line 1183-1184)
-          // This would require tokenizer API extensions
+          tokenizer.set_language(language);
         }
       }
     }
@@ -909,10 +1182,19 @@ std::vector<Segment> WhisperModel::generate_segments(
     // Generate with fallback (Python line 1194-1199)
     //logTranscribeTimestamp("Starting generate_with_fallback");
 
-    auto [result, avg_logprob, temperature, compression_ratio] = generate_with_fallback(
-      encoder_output, prompt, tokenizer, options
+    float no_speech_prob = 0.0f;
+    auto [result, avg_logprob, temperature, compression_ratio, beam_size] = generate_with_fallback(
+      encoder_output, prompt, tokenizer, options, segment_duration, control, &no_speech_prob
     );
 
+    // No speech detection (Python line 1201-1221); a likely silent window is
+    // confirmed by a greedy attempt before any beam search, so it costs a
+    // one-step probe and a greedy decode
+    if (is_silent_window(no_speech_prob, avg_logprob, options)) {
+      seek += segment_size;
+      continue;
+    }
+
     // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "generate_with_fallback completed successfully");
     // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Generated %zu tokens", result.size());
 
@@ -929,14 +1211,9 @@ std::vector<Segment> WhisperModel::generate_segments(
     //   __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Decoded result: '%s'", decoded_result.c_str());
     // }
 
-    // No speech detection (Python line 1201-1221)
-    if (options.no_speech_threshold.has_value()) {
-      // This requires access to result.no_speech_prob from CTranslate2
-      // For now, skip this check
-    }
-
     std::vector<int> tokens = result;
     int previous_seek = seek;
+    float window_end_time = (seek + segment_size) * feature_extractor.time_per_frame();
 
     // Split segments by timestamps (Python line 1251-1262)
     auto [current_segments, new_seek, single_timestamp_ending] = split_segments_by_timestamps(
@@ -944,32 +1221,15 @@ std::vector<Segment> WhisperModel::generate_segments(
     );
     seek = new_seek;
 
-    // Process current segments (Python line 1330-1356)
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Processing %zu segments", current_segments.size());
+    // Segments of this window with text (Python line 1264-1276)
+    std::vector<Segment> window_segments;
     for (auto& segment : current_segments) {
-      // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "About to decode segment with %zu tokens...", segment.tokens.size());
-
-      // Log the tokens before decoding
-      // std::string tokens_debug = "Segment tokens: ";
-      // for (size_t i = 0; i < std::min(segment.tokens.size(), size_t(20)); ++i) {
-      //   tokens_debug += std::to_string(segment.tokens[i]) + " ";
-      // }
-      // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "%s", tokens_debug.c_str());
-
       std::string text = tokenizer.decode(segment.tokens);
-      // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "✅ Segment decode completed! Text: '%s' (tokens: %zu)", text.c_str(), segment.tokens.size());
-
       if (segment.start == segment.end || text.empty()) {
-        // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Skipping empty segment");
         continue;
       }
 
-      all_tokens.insert(all_tokens.end(), segment.tokens.begin(), segment.tokens.end());
-      idx++;
-
-      // Create segment object
       Segment seg;
-      seg.id = idx;
       seg.seek = previous_seek;
       seg.start = segment.start;
       seg.end = segment.end;
@@ -978,31 +1238,94 @@ std::vector<Segment> WhisperModel::generate_segments(
       seg.temperature = temperature;
       seg.avg_logprob = avg_logprob;
       seg.compression_ratio = compression_ratio;
-      seg.no_speech_prob = 0.0f; // Would need CTranslate2 result
-      seg.words = std::nullopt; // Word timestamps handled separately
+      seg.no_speech_prob = no_speech_prob;
+      seg.words = std::nullopt;
+      seg.beam_size = beam_size;
+      window_segments.push_back(seg);
+    }
+
+    if (options.word_timestamps) {
+      // One align call for the whole window (Python line 1278-1293)
+      generate_word_timestamps(
+        window_segments, tokenizer, encoder_output, segment_size, options, last_speech_timestamp
+      );
+      if (!single_timestamp_ending) {
+        for (auto it = window_segments.rbegin(); it != window_segments.rend(); ++it) {
+          if (it->words.has_value() && !it->words->empty()) {
+            if (it->words->back().end > time_offset) {
+              seek = static_cast<int>(std::round(it->words->back().end * frames_per_second));
+            }
+            break;
+          }
+        }
+      }
+
+      // Skip silence before possible hallucinations (Python line 1295-1349)
+      if (options.hallucination_silence_threshold.has_value()) {
+        float threshold = options.hallucination_silence_threshold.value();
+
+        // If the first segment might be a hallucination, skip the leading silence
+        const Segment *first_segment = next_words_segment(window_segments, 0);
+        if (first_segment && is_segment_anomaly(first_segment)) {
+          float gap = first_segment->start - time_offset;
+          if (gap > threshold) {
+            seek = previous_seek + static_cast<int>(std::round(gap * frames_per_second));
+            continue;
+          }
+        }
+
+        // Skip silence before any possible hallucination that is surrounded
+        // by silence or more hallucinations
+        float hal_last_end = last_speech_timestamp;
+        for (size_t si = 0; si < window_segments.size(); ++si) {
+          const Segment &segment = window_segments[si];
+          if (!segment.words.has_value() || segment.words->empty()) {
+            continue;
+          }
+          if (is_segment_anomaly(&segment)) {
+            const Segment *next_segment = next_words_segment(window_segments, si + 1);
+            float hal_next_start = next_segment ?
+                                   next_segment->words->front().start :
+                                   time_offset + segment_duration;
+            bool silence_before = segment.start - hal_last_end > threshold ||
+                                  segment.start < threshold ||
+                                  segment.start - time_offset < 2.0f;
+            bool silence_after = hal_next_start - segment.end > threshold ||
+                                 is_segment_anomaly(next_segment) ||
+                                 window_end_time - segment.end < 2.0f;
+            if (silence_before && silence_after) {
+              seek = static_cast<int>(std::round(std::max(time_offset + 1.0f, segment.start) * frames_per_second));
+              if (content_duration - segment.end < threshold) {
+                seek = content_frames;
+              }
+              window_segments.resize(si);
+              break;
+            }
+          }
+          hal_last_end = segment.end;
+        }
+      }
+
+      for (auto it = window_segments.rbegin(); it != window_segments.rend(); ++it) {
+        if (it->words.has_value() && !it->words->empty()) {
+          last_speech_timestamp = it->words->back().end;
+          break;
+        }
+      }
+    }
+
+    // Process current segments (Python line 1330-1356)
+    for (auto& seg : window_segments) {
+      all_tokens.insert(all_tokens.end(), seg.tokens.begin(), seg.tokens.end());
+      seg.id = ++idx;
 
       all_segments.push_back(seg);
+      if (on_segment) {
+        on_segment(all_segments.back());
+      }
 
-      // Print in Python format
-      std::ostringstream token_msg;
-      //token_msg << "Generated tokens (" << segment.tokens.size() << ")";
-      //logTranscribeTimestamp(token_msg.str());
-      //std::cout << "  Generated tokens (" << segment.tokens.size() << "): [";
-//      for (size_t i = 0; i < std::min(size_t(20), segment.tokens.size()); ++i) {
-//        if (i > 0) std::cout << ", ";
-//        std::cout << segment.tokens[i];
-//      }
-//      if (segment.tokens.size() > 20) {
-//        std::cout << "], ..., [";
-//        size_t start_idx = std::max(size_t(0), segment.tokens.size() - 3);
-//        for (size_t i = start_idx; i < segment.tokens.size(); ++i) {
-//          if (i > start_idx) std::cout << ", ";
-//          std::cout << segment.tokens[i];
-//        }
-//      }
-      std::cout << "]" << std::endl;
-      std::cout << "[" << std::fixed << std::setprecision(2) << segment.start << "s -> " << segment.end << "s]" << std::endl;
-      std::cout << text << std::endl;
+      std::cout << "[" << std::fixed << std::setprecision(2) << seg.start << "s -> " << seg.end << "s]" << std::endl;
+      std::cout << seg.text << std::endl;
     }
 
     // Prompt reset logic (Python line 1358-1369)
@@ -1019,6 +1342,262 @@ std::vector<Segment> WhisperModel::generate_segments(
   return all_segments;
 }
 
+std::vector<Segment> WhisperModel::generate_segments_batched(
+  const std::vector<std::vector<float>> &features,
+  const std::vector<std::pair<int, int>> &seek_clips,
+  const std::vector<int> &initial_tokens,
+  Tokenizer &tokenizer,
+  const TranscriptionOptions &options,
+  const std::function<void(const Segment &)> &on_segment,
+  const TranscriptionControl *control,
+  EncoderCache *encoder_cache
+) {
+  int content_frames = features[0].size() - 1;
+
+  // Fixed 30s strides over every clip; each window is decoded on its own
+  std::vector<std::pair<int, int>> windows;
+  for (auto [seek_clip_start, seek_clip_end] : seek_clips) {
+    seek_clip_end = std::min(seek_clip_end, content_frames);
+    for (int seek = seek_clip_start; seek < seek_clip_end; seek += feature_extractor.nb_max_frames()) {
+      windows.emplace_back(seek, std::min(feature_extractor.nb_max_frames(), seek_clip_end - seek));
+    }
+  }
+
+  // Only the first window sees the initial prompt and the prefix
+  std::vector<std::vector<int>> window_prompts;
+  for (size_t i = 0; i < windows.size(); ++i) {
+    window_prompts.push_back(get_prompt(
+      tokenizer,
+      i == 0 ? initial_tokens : std::vector<int>(),
+      options.without_timestamps,
+      (windows[i].first == 0) ? options.prefix : std::nullopt,
+      options.hotwords
+    ));
+  }
+
+  std::vector<Segment> all_segments;
+  int idx = 0;
+  size_t batch_size = static_cast<size_t>(options.batch_size);
+  float last_speech_timestamp = 0.0f;
+
+  size_t batch_end = 0;
+  for (size_t batch_start = 0; batch_start < windows.size(); batch_start = batch_end) {
+    if (control && control->should_stop()) {
+      break;
+    }
+
+    // Prompts in one generate call must have the same length
+    batch_end = batch_start + 1;
+    while (batch_end < windows.size() && batch_end - batch_start < batch_size &&
+           window_prompts[batch_end].size() == window_prompts[batch_start].size()) {
+      ++batch_end;
+    }
+
+    // Windows already encoded for language detection come from the cache
+    std::vector<std::optional<ctranslate2::StorageView>> cached(batch_end - batch_start);
+    std::vector<std::vector<std::vector<float>>> batch_features;
+    std::vector<std::vector<int>> prompts(window_prompts.begin() + batch_start, window_prompts.begin() + batch_end);
+    for (size_t i = batch_start; i < batch_end; ++i) {
+      auto [seek, segment_size] = windows[i];
+      if (encoder_cache) {
+        auto it = encoder_cache->outputs.find(encoder_cache_key(seek, segment_size));
+        if (it != encoder_cache->outputs.end()) {
+          cached[i - batch_start] = std::move(it->second);
+          encoder_cache->outputs.erase(it);
+          continue;
+        }
+      }
+      batch_features.push_back(pad_or_trim(slice_features(features, seek, segment_size)));
+    }
+    if (encoder_cache) {
+      encoder_cache->encoded_windows += static_cast<int>(batch_features.size());
+    }
+
+    // One [K, n_mels, 3000] encode and one K-prompt generate for the batch;
+    // cached outputs are joined with the encoded ones in window order
+    ctranslate2::StorageView encoder_output;
+    if (batch_features.size() == prompts.size()) {
+      encoder_output = encode_batch(batch_features);
+    } else {
+      ctranslate2::StorageView encoded;
+      if (!batch_features.empty()) {
+        encoded = encode_batch(batch_features);
+      }
+      std::vector<ctranslate2::StorageView> items;
+      long encoded_index = 0;
+      for (auto &output : cached) {
+        items.push_back(output.has_value() ? std::move(output.value()) : slice_batch(encoded, encoded_index++));
+      }
+      if (items.size() == 1) {
+        encoder_output = std::move(items[0]);
+      } else {
+        std::vector<const ctranslate2::StorageView *> inputs;
+        for (const auto &item : items) {
+          inputs.push_back(&item);
+        }
+        encoder_output = ctranslate2::StorageView(items[0].dtype(), items[0].device());
+        ctranslate2::ops::Concat(0)(inputs, encoder_output);
+      }
+    }
+
+    float first_temperature = options.temperatures.empty() ? 0.0f : options.temperatures[0];
+    float batch_seconds = 0.0f;
+    for (size_t i = batch_start; i < batch_end; ++i) {
+      batch_seconds = std::max(batch_seconds, windows[i].second * feature_extractor.time_per_frame());
+    }
+    size_t max_prompt_size = 0;
+    std::vector<std::vector<size_t>> prompts_size_t;
+    for (const auto &prompt : prompts) {
+      prompts_size_t.emplace_back(prompt.begin(), prompt.end());
+      max_prompt_size = std::max(max_prompt_size, prompt.size());
+    }
+    auto result_futures = model->generate(
+      encoder_output, prompts_size_t,
+      get_whisper_options(options, first_temperature, max_prompt_size, batch_seconds)
+    );
+
+    for (size_t i = batch_start; i < batch_end; ++i) {
+      size_t batch_index = i - batch_start;
+      auto [seek, segment_size] = windows[i];
+
+      std::vector<std::tuple<std::vector<int>, float, float, float, int>> all_results;
+      std::vector<std::tuple<std::vector<int>, float, float, float, int>> below_cr_threshold_results;
+      auto result = result_futures[batch_index].get();
+
+      std::tuple<std::vector<int>, float, float, float, int> decode_result;
+      if (evaluate_generation(result, first_temperature, options.beam_size, tokenizer, options, all_results, below_cr_threshold_results)) {
+        // Only this window retries the next temperatures, on its own encoder output
+        decode_result = continue_with_fallback(
+          slice_batch(encoder_output, batch_index), prompts[batch_index], tokenizer, options,
+          segment_size * feature_extractor.time_per_frame(), 1,
+          std::move(all_results), std::move(below_cr_threshold_results), control
+        );
+      } else {
+        decode_result = all_results.back();
+      }
+      auto [tokens, avg_logprob, temperature, compression_ratio, beam_size] = decode_result;
+      if (is_silent_window(result.no_speech_prob, avg_logprob, options)) {
+        continue;
+      }
+
+      auto window_results = decode_window_segments(
+        tokenizer, tokens, seek, segment_size, avg_logprob, temperature, compression_ratio,
+        result.no_speech_prob, beam_size, idx
+      );
+      if (options.word_timestamps) {
+        generate_word_timestamps(
+          window_results, tokenizer, slice_batch(encoder_output, batch_index), segment_size, options,
+          last_speech_timestamp
+        );
+        if (!window_results.empty() && window_results.back().words.has_value() &&
+            !window_results.back().words->empty()) {
+          last_speech_timestamp = window_results.back().words->back().end;
+        }
+      }
+      for (auto &segment : window_results) {
+        all_segments.push_back(std::move(segment));
+        if (on_segment) {
+          on_segment(all_segments.back());
+        }
+      }
+    }
+  }
+
+  return all_segments;
+}
+
+std::vector<Segment> WhisperModel::decode_window_segments(
+  Tokenizer &tokenizer,
+  const std::vector<int> &tokens,
+  int seek,
+  int segment_size,
+  float avg_logprob,
+  float temperature,
+  float compression_ratio,
+  float no_speech_prob,
+  int beam_size,
+  int &idx
+) {
+  float time_offset = seek * feature_extractor.time_per_frame();
+  float segment_duration = segment_size * feature_extractor.time_per_frame();
+
+  auto [current_segments, new_seek, single_timestamp_ending] = split_segments_by_timestamps(
+    tokenizer, tokens, time_offset, segment_size, segment_duration, seek
+  );
+
+  // The window is not re-decoded from new_seek, so text after the last
+  // timestamp pair becomes a segment running to the end of the window
+  size_t consumed = 0;
+  for (const auto &segment : current_segments) {
+    consumed += segment.tokens.size();
+  }
+  if (consumed < tokens.size()) {
+    std::vector<int> tail(tokens.begin() + consumed, tokens.end());
+    bool has_text = std::any_of(tail.begin(), tail.end(), [&tokenizer](int token) {
+      return token < tokenizer.get_eot();
+    });
+    if (has_text) {
+      Segment tail_segment;
+      tail_segment.seek = seek;
+      tail_segment.start = new_seek * feature_extractor.time_per_frame();
+      tail_segment.end = time_offset + segment_duration;
+      tail_segment.tokens = tail;
+      current_segments.push_back(tail_segment);
+    }
+  }
+
+  std::vector<Segment> window_segments;
+  for (auto &segment : current_segments) {
+    std::string text = tokenizer.decode(segment.tokens);
+    if (segment.start == segment.end || text.empty()) {
+      continue;
+    }
+
+    Segment seg;
+    seg.id = ++idx;
+    seg.seek = seek;
+    seg.start = segment.start;
+    seg.end = segment.end;
+    seg.text = text;
+    seg.tokens = segment.tokens;
+    seg.temperature = temperature;
+    seg.avg_logprob = avg_logprob;
+    seg.compression_ratio = compression_ratio;
+    seg.no_speech_prob = no_speech_prob;
+    seg.words = std::nullopt; // Word timestamps handled separately
+    seg.beam_size = beam_size;
+    window_segments.push_back(seg);
+
+    std::cout << "[" << std::fixed << std::setprecision(2) << seg.start << "s -> " << seg.end << "s]" << std::endl;
+    std::cout << text << std::endl;
+  }
+
+  return window_segments;
+}
+
+std::pair<size_t, size_t> WhisperModel::encoder_cache_key(int seek, int size) const {
+  size_t hop_length = static_cast<size_t>(feature_extractor.hop_length);
+  return {static_cast<size_t>(seek) * hop_length, static_cast<size_t>(size) * hop_length};
+}
+
+ctranslate2::StorageView WhisperModel::encode_window(
+  const std::vector<std::vector<float>> &features,
+  int seek,
+  int size,
+  EncoderCache *encoder_cache
+) {
+  if (encoder_cache) {
+    auto it = encoder_cache->outputs.find(encoder_cache_key(seek, size));
+    if (it != encoder_cache->outputs.end()) {
+      ctranslate2::StorageView output = std::move(it->second);
+      encoder_cache->outputs.erase(it);
+      return output;
+    }
+    ++encoder_cache->encoded_windows;
+  }
+  return encode(pad_or_trim(slice_features(features, seek, size)));
+}
+
 // --------------------------
 // Encode features using the Whisper model
 // --------------------------
@@ -1059,205 +1638,373 @@ ctranslate2::StorageView WhisperModel::encode(const std::vector<std::vector<floa
   }
 }
 
+ctranslate2::StorageView WhisperModel::encode_batch(const std::vector<std::vector<std::vector<float>>> &batch_features) {
+  if (batch_features.empty()) {
+    throw std::runtime_error("Cannot encode an empty batch");
+  }
+
+  auto storage = get_ctranslate2_storage_3d(batch_features);
+  try {
+    return model->encode(storage, false).get();
+  } catch (const std::exception& e) {
+    __android_log_print(ANDROID_LOG_ERROR, "#transcribe", "EXCEPTION in model->encode(): %s", e.what());
+    throw;
+  }
+}
+
 // --------------------------
 // Generate with fallback loop over temperatures
 // --------------------------
-std::tuple<std::vector<int>, float, float, float>
+std::tuple<std::vector<int>, float, float, float, int>
 WhisperModel::generate_with_fallback(
   const ctranslate2::StorageView &encoder_output,
   const std::vector<int> &prompt,
   Tokenizer &tokenizer,
-  const TranscriptionOptions &options
+  const TranscriptionOptions &options,
+  float window_seconds,
+  const TranscriptionControl *control,
+  float *no_speech_prob
 ) {
-  // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "=== ENTERING generate_with_fallback ===");
-  // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Encoder output shape: [%lld, %lld, %lld]",
-  //                     (long long)encoder_output.shape()[0], (long long)encoder_output.shape()[1], (long long)encoder_output.shape()[2]);
-  // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Prompt size: %zu", prompt.size());
-  // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Temperature options count: %zu", options.temperatures.size());
-
   // Follow Python implementation from line 1388-1516
-  std::tuple<std::vector<int>, float, float, float> decode_result;
-  std::vector<std::tuple<std::vector<int>, float, float, float>> all_results;
-  std::vector<std::tuple<std::vector<int>, float, float, float>> below_cr_threshold_results;
+  return continue_with_fallback(
+    encoder_output, prompt, tokenizer, options, window_seconds, 0, {}, {}, control, no_speech_prob
+  );
+}
 
-  // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Calculating max_initial_timestamp_index...");
+ctranslate2::models::WhisperOptions WhisperModel::get_whisper_options(
+  const TranscriptionOptions &options,
+  float temperature,
+  size_t prompt_size,
+  float window_seconds
+) const {
   int max_initial_timestamp_index = static_cast<int>(
     std::round(options.max_initial_timestamp / time_precision)
   );
-  // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "max_initial_timestamp_index: %d", max_initial_timestamp_index);
 
-  // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Calculating max_length...");
   int max_length = options.max_new_tokens.has_value() ?
-                   prompt.size() + options.max_new_tokens.value() :
+                   prompt_size + options.max_new_tokens.value() :
                    this->max_length; // Use model's max_length (448 or 512) to match Python
-  // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "max_length: %d, this->max_length: %d", max_length, this->max_length);
 
   if (max_length > this->max_length) {
     throw std::runtime_error("Prompt + max_new_tokens exceeds Whisper max_length");
   }
 
-  // Iterate through temperatures (Python line 1418)
-  // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Starting temperature loop...");
+  // Token budget from the window duration, so a runaway decode on a short
+  // window stops long before the model's max_length
+  if (!options.max_new_tokens.has_value() && options.max_tokens_per_second > 0.0f && window_seconds > 0.0f) {
+    int budget = options.token_budget_margin +
+                 static_cast<int>(std::ceil(options.max_tokens_per_second * window_seconds));
+    max_length = std::min(max_length, static_cast<int>(prompt_size) + budget);
+  }
 
-  for (size_t temp_idx = 0; temp_idx < options.temperatures.size(); ++temp_idx) {
-    float temperature = options.temperatures[temp_idx];
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "=== Temperature iteration %zu/%zu: %.2f ===",
-    //                     temp_idx + 1, options.temperatures.size(), temperature);
-
-    // Configure generation options based on temperature (Python line 1419-1430)
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Configuring whisper_options...");
-    ctranslate2::models::WhisperOptions whisper_options;
-
-    // Use proper beam search like Python faster-whisper
-    whisper_options.beam_size = options.beam_size;  // Use configured beam size (5)
-    whisper_options.patience = options.patience;    // Beam search patience for early stopping
-    whisper_options.num_hypotheses = 1;  // Single best hypothesis
-    if (temperature == 0.0f) {
-      // Greedy search - no sampling
-      whisper_options.sampling_topk = 1;  // Greedy
-      whisper_options.sampling_temperature = 1.0f;  // No effect in greedy
-    } else {
-      // Sampling with temperature
-      whisper_options.sampling_topk = 0;  // No top-k restriction
-      whisper_options.sampling_temperature = temperature;  // Use sampling temperature
-    }
-
-    whisper_options.length_penalty = options.length_penalty;
-    whisper_options.repetition_penalty = options.repetition_penalty;
-    whisper_options.no_repeat_ngram_size = options.no_repeat_ngram_size;
-    whisper_options.max_length = max_length;
-    whisper_options.suppress_blank = options.suppress_blank;
-    whisper_options.max_initial_timestamp_index = max_initial_timestamp_index;
-
-    if (options.suppress_tokens.has_value()) {
-      // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Setting suppress_tokens...");
-      std::vector<int> suppress_tokens_int;
-      for (int token : options.suppress_tokens.value()) {
-        suppress_tokens_int.push_back(token);
-      }
-      whisper_options.suppress_tokens = suppress_tokens_int;
-      // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "suppress_tokens set with %zu tokens", suppress_tokens_int.size());
+  // Configure generation options based on temperature (Python line 1419-1430)
+  ctranslate2::models::WhisperOptions whisper_options;
+
+  // Use proper beam search like Python faster-whisper
+  whisper_options.beam_size = options.beam_size;  // Use configured beam size (5)
+  whisper_options.patience = options.patience;    // Beam search patience for early stopping
+  whisper_options.num_hypotheses = 1;  // Single best hypothesis
+  whisper_options.return_scores = true;  // avg_logprob for the log-prob fallback
+  whisper_options.return_no_speech_prob = true;
+  if (temperature == 0.0f) {
+    // Greedy search - no sampling
+    whisper_options.sampling_topk = 1;  // Greedy
+    whisper_options.sampling_temperature = 1.0f;  // No effect in greedy
+  } else {
+    // Sampling with temperature
+    whisper_options.sampling_topk = 0;  // No top-k restriction
+    whisper_options.sampling_temperature = temperature;  // Use sampling temperature
+  }
+
+  whisper_options.length_penalty = options.length_penalty;
+  whisper_options.repetition_penalty = options.repetition_penalty;
+  whisper_options.no_repeat_ngram_size = options.no_repeat_ngram_size;
+  whisper_options.max_length = max_length;
+  whisper_options.suppress_blank = options.suppress_blank;
+  whisper_options.max_initial_timestamp_index = max_initial_timestamp_index;
+
+  if (options.suppress_tokens.has_value()) {
+    std::vector<int> suppress_tokens_int;
+    for (int token : options.suppress_tokens.value()) {
+      suppress_tokens_int.push_back(token);
     }
+    whisper_options.suppress_tokens = suppress_tokens_int;
+  }
 
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Converting prompt to size_t...");
-    // Convert prompt to size_t for CTranslate2 (Python line 1432-1445)
-    std::vector<size_t> prompt_size_t(prompt.begin(), prompt.end());
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Prompt converted: %zu tokens", prompt_size_t.size());
+  return whisper_options;
+}
 
-    // CRITICAL DEBUG: Log the actual prompt being sent to the model
-    // std::string full_prompt_debug = "🚨 FULL PROMPT being sent to model: ";
-    // for (size_t i = 0; i < prompt_size_t.size(); ++i) {
-    //   full_prompt_debug += std::to_string(prompt_size_t[i]) + " ";
-    // }
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "%s", full_prompt_debug.c_str());
-
-    // Verify Arabic SOT sequence
-    // if (prompt_size_t.size() >= 3) {
-    //   __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "🔍 Checking Arabic SOT sequence:");
-    //   __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "   Token 0 (should be SOT 50258): %zu", prompt_size_t[0]);
-    //   __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "   Token 1 (should be Arabic lang 50272): %zu", prompt_size_t[1]);
-    //   __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "   Token 2 (should be transcribe 50359): %zu", prompt_size_t[2]);
-    // }
+ctranslate2::models::WhisperGenerationResult WhisperModel::generate_chunked(
+  const ctranslate2::StorageView &encoder_output,
+  const std::vector<size_t> &prompt,
+  const ctranslate2::models::WhisperOptions &whisper_options,
+  Tokenizer &tokenizer,
+  const TranscriptionOptions &options,
+  bool &looping,
+  const std::atomic<bool> *abandon
+) {
+  looping = false;
+  ctranslate2::models::WhisperGenerationResult combined;
+  std::vector<size_t> generated;
+  float cum_logprob = 0.0f;
+  size_t chunk_tokens = static_cast<size_t>(options.decode_chunk_tokens);
+
+  // Each chunk restarts the search from the best hypothesis so far, so beam
+  // search only looks ahead within a chunk
+  while (prompt.size() + generated.size() < whisper_options.max_length) {
+    if (abandon && abandon->load()) {
+      break;
+    }
+    std::vector<size_t> chunk_prompt = prompt;
+    chunk_prompt.insert(chunk_prompt.end(), generated.begin(), generated.end());
+
+    ctranslate2::models::WhisperOptions chunk_options = whisper_options;
+    chunk_options.max_length = std::min(whisper_options.max_length, chunk_prompt.size() + chunk_tokens);
+    chunk_options.return_no_speech_prob = generated.empty();
+    // CTranslate2 treats the first step of every call as the start of the
+    // text, where blank and EOT are suppressed; a continuation is mid-text
+    if (!generated.empty()) {
+      chunk_options.suppress_blank = false;
+    }
 
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "About to call model->generate() - THIS IS THE CRITICAL CALL");
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "WhisperOptions configured: beam_size=%zu, max_length=%zu, temperature=%.2f",
-    //                     (size_t)whisper_options.beam_size, (size_t)whisper_options.max_length, temperature);
+    auto result = model->generate(encoder_output, {chunk_prompt}, chunk_options)[0].get();
+    if (generated.empty()) {
+      combined.no_speech_prob = result.no_speech_prob;
+    }
+    if (result.sequences_ids.empty()) {
+      break;
+    }
+    const auto &new_tokens = result.sequences_ids[0];
+    if (!result.scores.empty() && !new_tokens.empty()) {
+      cum_logprob += result.scores[0] * std::pow(new_tokens.size(), whisper_options.length_penalty);
+    }
+    generated.insert(generated.end(), new_tokens.begin(), new_tokens.end());
 
-    try {
-      //logTranscribeTimestamp("Calling model->generate()");
-      auto result_futures = model->generate(encoder_output, {prompt_size_t}, whisper_options);
-
-      auto start_time = std::chrono::steady_clock::now();
-      auto result = result_futures[0].get();
-      auto end_time = std::chrono::steady_clock::now();
-
-      auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-      std::ostringstream duration_msg;
-      //duration_msg << "result.get() completed in " << duration.count() << "ms";
-      //logTranscribeTimestamp(duration_msg.str());
-
-      // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Result sequences count: %zu", result.sequences_ids.size());
-      // if (!result.sequences_ids.empty()) {
-      //   __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "First sequence length: %zu", result.sequences_ids[0].size());
-      // }
-      // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Result scores count: %zu", result.scores.size());
-
-      // Extract tokens and calculate metrics (Python line 1447-1455)
-      // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Extracting tokens from result...");
-      std::vector<int> tokens;
-      if (!result.sequences_ids.empty() && !result.sequences_ids[0].empty()) {
-        const auto &tokens_size_t = result.sequences_ids[0];
-        tokens.assign(tokens_size_t.begin(), tokens_size_t.end());
-
-        // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Extracted %zu tokens", tokens.size());
-      } else {
-        // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "No tokens in result sequences!");
-      }
-      // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Before seq_len = tokens.size()");
-      int seq_len = tokens.size();
-      // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "After seq_len = tokens.size()");
-
-      // Check if scores array is available
-      float cum_logprob = 0.0f;
-      float avg_logprob = 0.0f;
-
-      if (!result.scores.empty()) {
-        // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Calculating scores - result.scores[0]: %.4f", result.scores[0]);
-        cum_logprob = result.scores[0] * std::pow(seq_len, options.length_penalty);
-        // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "After options.length_penalty calculation");
-        avg_logprob = cum_logprob / (seq_len + 1);
-        // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Calculated avg_logprob: %.4f", avg_logprob);
-      } else {
-        // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "⚠️ result.scores is EMPTY! Using default values: cum_logprob=0.0, avg_logprob=0.0");
-        // Use default values when scores are not available
-        cum_logprob = 0.0f;
-        avg_logprob = 0.0f;
-      }
+    // A chunk that stopped before its budget reached the end of the text
+    if (chunk_prompt.size() + new_tokens.size() < chunk_options.max_length) {
+      break;
+    }
 
-      // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "About to call tokenizer.decode() - THIS IS THE LIKELY BOTTLENECK");
-      // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Decoding %zu tokens...", tokens.size());
+    std::vector<int> tokens(generated.begin(), generated.end());
+    if (has_repetition_loop(tokens, tokenizer.get_eot(), options.repetition_loop_count) ||
+        (options.compression_ratio_threshold.has_value() &&
+         get_compression_ratio(tokenizer.decode(tokens)) > options.compression_ratio_threshold.value())) {
+      looping = true;
+      break;
+    }
+  }
 
-      // Calculate compression ratio (Python line 1454-1455)
-      // CRITICAL: This decode() call is likely where we're getting stuck
-      std::string text = tokenizer.decode(tokens);
+  combined.sequences_ids = {generated};
+  if (!generated.empty()) {
+    combined.scores = {static_cast<float>(cum_logprob / std::pow(generated.size(), whisper_options.length_penalty))};
+  }
+  return combined;
+}
 
-      // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "✅ tokenizer.decode() COMPLETED!");
-      // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Generated text: '%s'", text.c_str());
+bool WhisperModel::evaluate_generation(
+  const ctranslate2::models::WhisperGenerationResult &result,
+  float temperature,
+  int beam_size,
+  Tokenizer &tokenizer,
+  const TranscriptionOptions &options,
+  std::vector<std::tuple<std::vector<int>, float, float, float, int>> &all_results,
+  std::vector<std::tuple<std::vector<int>, float, float, float, int>> &below_cr_threshold_results
+) {
+  // Extract tokens and calculate metrics (Python line 1447-1455)
+  std::vector<int> tokens;
+  if (!result.sequences_ids.empty() && !result.sequences_ids[0].empty()) {
+    const auto &tokens_size_t = result.sequences_ids[0];
+    tokens.assign(tokens_size_t.begin(), tokens_size_t.end());
+  }
+  int seq_len = tokens.size();
 
-      // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Calculating compression ratio...");
-      float compression_ratio = get_compression_ratio(text);
-      // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "✅ Compression ratio calculated: %.2f, avg_logprob: %.4f", compression_ratio, avg_logprob);
+  // Use default values when scores are not available
+  float cum_logprob = 0.0f;
+  float avg_logprob = 0.0f;
+  if (!result.scores.empty()) {
+    cum_logprob = result.scores[0] * std::pow(seq_len, options.length_penalty);
+    avg_logprob = cum_logprob / (seq_len + 1);
+  }
 
-      decode_result = std::make_tuple(tokens, avg_logprob, temperature, compression_ratio);
-      all_results.push_back(decode_result);
+  // Calculate compression ratio (Python line 1454-1455)
+  std::string text = tokenizer.decode(tokens);
+  float compression_ratio = get_compression_ratio(text);
 
-      bool needs_fallback = false;
+  auto decode_result = std::make_tuple(tokens, avg_logprob, temperature, compression_ratio, beam_size);
+  all_results.push_back(decode_result);
 
-      // Check compression ratio threshold (Python line 1467-1478)
-      if (options.compression_ratio_threshold.has_value() &&
-          compression_ratio > options.compression_ratio_threshold.value()) {
-        needs_fallback = true;
-      } else {
-        below_cr_threshold_results.push_back(decode_result);
-      }
+  bool needs_fallback = false;
 
-      // Check log probability threshold (Python line 1480-1491)
-      if (options.log_prob_threshold.has_value() &&
-          avg_logprob < options.log_prob_threshold.value()) {
-        needs_fallback = true;
-      }
+  // Check compression ratio threshold (Python line 1467-1478)
+  if (options.compression_ratio_threshold.has_value() &&
+      compression_ratio > options.compression_ratio_threshold.value()) {
+    needs_fallback = true;
+  } else {
+    below_cr_threshold_results.push_back(decode_result);
+  }
+
+  // Check log probability threshold (Python line 1480-1491)
+  if (options.log_prob_threshold.has_value() &&
+      avg_logprob < options.log_prob_threshold.value()) {
+    needs_fallback = true;
+  }
+
+  // Check no speech threshold (Python line 1493-1499)
+  if (options.no_speech_threshold.has_value() &&
+      result.no_speech_prob > options.no_speech_threshold.value() &&
+      options.log_prob_threshold.has_value() &&
+      avg_logprob < options.log_prob_threshold.value()) {
+    needs_fallback = false; // silence
+  }
+
+  return needs_fallback;
+}
+
+std::tuple<std::vector<int>, float, float, float, int>
+WhisperModel::continue_with_fallback(
+  const ctranslate2::StorageView &encoder_output,
+  const std::vector<int> &prompt,
+  Tokenizer &tokenizer,
+  const TranscriptionOptions &options,
+  float window_seconds,
+  size_t first_temperature_index,
+  std::vector<std::tuple<std::vector<int>, float, float, float, int>> all_results,
+  std::vector<std::tuple<std::vector<int>, float, float, float, int>> below_cr_threshold_results,
+  const TranscriptionControl *control,
+  float *no_speech_prob
+) {
+  // Convert prompt to size_t for CTranslate2 (Python line 1432-1445)
+  std::vector<size_t> prompt_size_t(prompt.begin(), prompt.end());
+
+  size_t temp_idx = first_temperature_index;
+
+  // With timestamps each continuation would be forced to start with an
+  // initial timestamp, so timestamped windows are decoded in one call
+  bool chunked = options.decode_chunk_tokens > 0 && options.without_timestamps;
+  auto decode = [&](const ctranslate2::models::WhisperOptions &whisper_options, bool &looping,
+                    const std::atomic<bool> *abandon = nullptr) {
+    looping = false;
+    return chunked ?
+      generate_chunked(encoder_output, prompt_size_t, whisper_options, tokenizer, options, looping, abandon) :
+      model->generate(encoder_output, {prompt_size_t}, whisper_options)[0].get();
+  };
 
-      // Check no speech threshold (Python line 1493-1499)
-      if (options.no_speech_threshold.has_value() &&
-          result.no_speech_prob > options.no_speech_threshold.value() &&
-          options.log_prob_threshold.has_value() &&
-          avg_logprob < options.log_prob_threshold.value()) {
-        // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "No speech detected, silence");
-        needs_fallback = false; // silence
+  // Scores one attempt; true when the next one is needed. An attempt stopped
+  // on a repetition loop always falls back and is never the best below-threshold result
+  auto evaluate = [&](const ctranslate2::models::WhisperGenerationResult &result, bool looping,
+                      float temperature, int beam_size) {
+    // Read at the first decoder step, so every attempt reports the same value
+    if (no_speech_prob) {
+      *no_speech_prob = result.no_speech_prob;
+    }
+    size_t below_cr_count = below_cr_threshold_results.size();
+    bool needs_fallback = evaluate_generation(
+      result, temperature, beam_size, tokenizer, options, all_results, below_cr_threshold_results
+    );
+    if (looping) {
+      below_cr_threshold_results.resize(below_cr_count);
+      return true;
+    }
+    return needs_fallback;
+  };
+
+  auto attempt = [&](const ctranslate2::models::WhisperOptions &whisper_options, float temperature) {
+    bool looping = false;
+    auto result = decode(whisper_options, looping);
+    return evaluate(result, looping, temperature, static_cast<int>(whisper_options.beam_size));
+  };
+
+  // Adaptive beam: a greedy attempt that passes the checks is kept, otherwise
+  // it stays a candidate and the beam search below runs as usual
+  bool beam_search_first = temp_idx == 0 && options.beam_size > 1 &&
+                           !options.temperatures.empty() && options.temperatures[0] == 0.0f;
+  bool greedy_first = options.adaptive_beam && beam_search_first;
+
+  // Silence gate: without adaptive beam, a one-step probe reads the no-speech
+  // probability first and only a likely silent window gets the greedy attempt
+  if (no_speech_prob && beam_search_first && !greedy_first && options.no_speech_threshold.has_value()) {
+    TranscriptionOptions probe_options = options;
+    probe_options.beam_size = 1;
+    probe_options.max_new_tokens = 1;
+    auto probe_futures = model->generate(
+      encoder_output, {prompt_size_t}, get_whisper_options(probe_options, 0.0f, prompt.size())
+    );
+    *no_speech_prob = probe_futures[0].get().no_speech_prob;
+    greedy_first = *no_speech_prob > options.no_speech_threshold.value();
+  }
+
+  if (greedy_first) {
+    TranscriptionOptions greedy_options = options;
+    greedy_options.beam_size = 1;
+    size_t all_count = all_results.size();
+    size_t below_cr_count = below_cr_threshold_results.size();
+    bool needs_fallback = attempt(get_whisper_options(greedy_options, 0.0f, prompt.size(), window_seconds), 0.0f);
+    if (options.adaptive_beam && !needs_fallback) {
+      return all_results.back();
+    }
+    // A silent window is dropped by the caller, so the beam search is skipped
+    if (no_speech_prob && is_silent_window(*no_speech_prob, std::get<1>(all_results.back()), options)) {
+      return all_results.back();
+    }
+    // A probed window that is not silent decodes as if the probe never ran
+    if (!options.adaptive_beam) {
+      all_results.resize(all_count);
+      below_cr_threshold_results.resize(below_cr_count);
+    }
+  }
+
+  // Speculative mode runs the first two temperatures at once on two replicas;
+  // they are still evaluated in order, so the selection is unchanged
+  if (options.speculative_fallback && temp_idx == 0 && options.temperatures.size() > 1 &&
+      model->num_queued_batches() == 0 && model->num_active_batches() + 1 < model->num_replicas()) {
+    auto first_options = get_whisper_options(options, options.temperatures[0], prompt.size(), window_seconds);
+    auto second_options = get_whisper_options(options, options.temperatures[1], prompt.size(), window_seconds);
+
+    if (chunked) {
+      // The chunk loop runs on the caller, so the sampled attempt gets its own
+      // thread; a discarded one stops at its next chunk boundary
+      std::atomic<bool> abandon{false};
+      bool first_looping = false;
+      bool second_looping = false;
+      auto second = std::async(std::launch::async, [&]() {
+        return decode(second_options, second_looping, &abandon);
+      });
+      auto first = decode(first_options, first_looping);
+      if (!evaluate(first, first_looping, options.temperatures[0], options.beam_size)) {
+        abandon = true;
+        return all_results.back();
       }
+      if (!evaluate(second.get(), second_looping, options.temperatures[1], options.beam_size)) {
+        return all_results.back();
+      }
+    } else {
+      std::vector<std::future<ctranslate2::models::WhisperGenerationResult>> attempts;
+      for (const auto *whisper_options: {&first_options, &second_options}) {
+        auto result_futures = model->generate(encoder_output, {prompt_size_t}, *whisper_options);
+        attempts.push_back(std::move(result_futures[0]));
+      }
+      for (size_t i = 0; i < 2; ++i) {
+        // A discarded sampled attempt finishes on its replica without being waited for
+        if (!evaluate(attempts[i].get(), false, options.temperatures[i], options.beam_size)) {
+          return all_results.back();
+        }
+      }
+    }
+    temp_idx = 2;
+  }
+
+  // Iterate through temperatures (Python line 1418)
+  for (; temp_idx < options.temperatures.size(); ++temp_idx) {
+    // A stopped run keeps the best attempt so far instead of trying more temperatures
+    if (control && !all_results.empty() && control->should_stop()) {
+      break;
+    }
+    float temperature = options.temperatures[temp_idx];
+    auto whisper_options = get_whisper_options(options, temperature, prompt.size(), window_seconds);
 
-      if (!needs_fallback) {
-        break; // Success, return this result
+    try {
+      if (!attempt(whisper_options, temperature)) {
+        return all_results.back(); // Success, return this result
       }
 
     } catch (const std::exception& e) {
@@ -1266,31 +2013,22 @@ WhisperModel::generate_with_fallback(
     }
   }
 
-  // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Temperature loop completed");
-
   // All temperatures failed, select best result (Python line 1504-1515)
-  // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Selecting best result from %zu below_cr_threshold and %zu all_results",
-  //                     below_cr_threshold_results.size(), all_results.size());
-
+  std::tuple<std::vector<int>, float, float, float, int> decode_result;
   if (!below_cr_threshold_results.empty()) {
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Using best from below_cr_threshold_results");
     auto best_it = std::max_element(
       below_cr_threshold_results.begin(), below_cr_threshold_results.end(),
       [](const auto &a, const auto &b) { return std::get<1>(a) < std::get<1>(b); }
     );
     decode_result = *best_it;
   } else if (!all_results.empty()) {
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Using best from all_results");
     auto best_it = std::max_element(
       all_results.begin(), all_results.end(),
       [](const auto &a, const auto &b) { return std::get<1>(a) < std::get<1>(b); }
     );
     decode_result = *best_it;
-  } else {
-    // __android_log_print(ANDROID_LOG_ERROR, "#transcribe", "No results available! This should not happen");
   }
 
-  // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "=== EXITING generate_with_fallback successfully ===");
   return decode_result;
 }
 
@@ -1311,7 +2049,7 @@ std::vector<int> WhisperModel::get_prompt(
   prompt.push_back(tokenizer.get_sot_prev());
 
   if (hotwords.has_value() && !prefix.has_value()) {
-    std::string hw = " " + hotwords.value();
+    std::string hw = " " + whisper::normalize_text(hotwords.value());
     std::vector<int> hotwords_tokens = tokenizer.encode(hw);
     if (hotwords_tokens.size() >= max_length / 2) {
       hotwords_tokens.resize(max_length / 2 - 1);
@@ -1353,7 +2091,7 @@ std::vector<int> WhisperModel::get_prompt(
   }
 
   if (prefix.has_value()) {
-    std::string pre = " " + prefix.value();
+    std::string pre = " " + whisper::normalize_text(prefix.value());
     std::vector<int> prefix_tokens = tokenizer.encode(pre);
     if (prefix_tokens.size() >= max_length / 2) {
       prefix_tokens.resize(max_length / 2 - 1);
@@ -1378,82 +2116,103 @@ float WhisperModel::add_word_timestamps(
 ) {
   if (segments.empty()) return last_speech_timestamp;
 
+  // Every group becomes one text sequence, so a window needs one align call
   std::vector<std::vector<int>> text_tokens;
   std::vector<std::vector<std::vector<int>>> text_tokens_per_segment;
 
   for (auto &segment: segments) {
-  std::vector<std::vector<int>> segment_tokens;
-  for (auto &subsegment: segment) {
-    std::vector<int> filtered_tokens;
-    auto tokens = std::any_cast<std::vector<int>>(subsegment["tokens"]);
-    std::copy_if(tokens.begin(), tokens.end(), std::back_inserter(filtered_tokens),
-       [&](int t) { return t < tokenizer.get_eot(); });
-    segment_tokens.push_back(filtered_tokens);
-  }
-  std::vector<int> flattened;
-  for (auto &tvec: segment_tokens)
-    flattened.insert(flattened.end(), tvec.begin(), tvec.end());
-  text_tokens.push_back(flattened);
-  text_tokens_per_segment.push_back(segment_tokens);
+    std::vector<std::vector<int>> segment_tokens;
+    for (auto &subsegment: segment) {
+      std::vector<int> filtered_tokens;
+      auto tokens = std::any_cast<std::vector<int>>(subsegment["tokens"]);
+      std::copy_if(tokens.begin(), tokens.end(), std::back_inserter(filtered_tokens),
+         [&](int t) { return t < tokenizer.get_eot(); });
+      segment_tokens.push_back(filtered_tokens);
+    }
+    std::vector<int> flattened;
+    for (auto &tvec: segment_tokens)
+      flattened.insert(flattened.end(), tvec.begin(), tvec.end());
+    text_tokens.push_back(flattened);
+    text_tokens_per_segment.push_back(segment_tokens);
   }
 
   auto alignments = find_alignment(tokenizer, text_tokens, encoder_output, num_frames);
 
   std::vector<std::pair<float, float>> median_max_durations;
   for (auto &alignment: alignments) {
-  std::vector<float> word_durations;
-  for (auto &word: alignment) {
-    float duration =
-    std::any_cast<float>(word.at("end")) - std::any_cast<float>(word.at("start"));
-    if (duration > 0) word_durations.push_back(duration);
-  }
+    std::vector<float> word_durations;
+    for (auto &word: alignment) {
+      float duration =
+      std::any_cast<float>(word.at("end")) - std::any_cast<float>(word.at("start"));
+      if (duration > 0) word_durations.push_back(duration);
+    }
 
-  float median_duration = 0.0f;
-  if (!word_durations.empty()) {
-    size_t mid = word_durations.size() / 2;
-    std::nth_element(word_durations.begin(), word_durations.begin() + mid, word_durations.end());
-    median_duration = word_durations[mid];
-  }
-  median_duration = std::min(0.7f, median_duration);
-  float max_duration = median_duration * 2.0f;
-  median_max_durations.push_back({median_duration, max_duration});
+    float median_duration = median_word_duration(word_durations);
+    float max_duration = median_duration * 2.0f;
+    median_max_durations.push_back({median_duration, max_duration});
+
+    // Truncate long words at sentence boundaries (Python line 1573-1582)
+    if (!word_durations.empty()) {
+      static const std::string sentence_end_marks = ".。!！?？";
+      auto is_sentence_end = [](const std::any &word) {
+        const auto &text = std::any_cast<const std::string &>(word);
+        return sentence_end_marks.find(text) != std::string::npos;
+      };
+      for (size_t i = 1; i < alignment.size(); ++i) {
+        float start = std::any_cast<float>(alignment[i]["start"]);
+        float end = std::any_cast<float>(alignment[i]["end"]);
+        if (end - start > max_duration) {
+          if (is_sentence_end(alignment[i]["word"])) {
+            alignment[i]["end"] = start + max_duration;
+          } else if (is_sentence_end(alignment[i - 1]["word"])) {
+            alignment[i]["start"] = end - max_duration;
+          }
+        }
+      }
+    }
 
-  // merge_punctuations(alignment, prepend_punctuations, append_punctuations);
-  // TODO: Fix type mismatch - alignment is vector<map<string,any>> but function expects vector<pair<string,float>>
+    merge_punctuations(alignment, prepend_punctuations, append_punctuations);
   }
 
   for (size_t segment_idx = 0; segment_idx < segments.size(); ++segment_idx) {
-  auto &segment = segments[segment_idx];
-  size_t word_index = 0;
-  float time_offset = std::any_cast<int>(segment[0]["seek"]) / frames_per_second;
-  auto [median_duration, max_duration] = median_max_durations[segment_idx];
-
-  for (size_t subsegment_idx = 0; subsegment_idx < segment.size(); ++subsegment_idx) {
-    auto &subsegment = segment[subsegment_idx];
-    int saved_tokens = 0;
-    std::vector<std::map<std::string, std::any>> words;
-
-    while (word_index < alignments[segment_idx].size() &&
-       saved_tokens < text_tokens_per_segment[segment_idx][subsegment_idx].size()) {
-      auto &timing = alignments[segment_idx][word_index];
-      if (timing.count("word") && !std::any_cast<std::string>(timing["word"]).empty()) {
-    words.push_back({
-          {"word",        timing["word"]},
-          {"start",       std::round(
-              (time_offset + std::any_cast<float>(timing["start"])) * 100) /
-                100},
-          {"end",         std::round(
-              (time_offset + std::any_cast<float>(timing["end"])) * 100) / 100},
-          {"probability", timing["probability"]}
-              });
+    auto &segment = segments[segment_idx];
+    size_t word_index = 0;
+    float time_offset = std::any_cast<int>(segment[0]["seek"]) / static_cast<float>(frames_per_second);
+    auto [median_duration, max_duration] = median_max_durations[segment_idx];
+
+    for (size_t subsegment_idx = 0; subsegment_idx < segment.size(); ++subsegment_idx) {
+      auto &subsegment = segment[subsegment_idx];
+      size_t saved_tokens = 0;
+      std::vector<Word> words;
+
+      while (word_index < alignments[segment_idx].size() &&
+             saved_tokens < text_tokens_per_segment[segment_idx][subsegment_idx].size()) {
+        auto &timing = alignments[segment_idx][word_index];
+        const auto &text = std::any_cast<const std::string &>(timing["word"]);
+        if (!text.empty()) {
+          Word word;
+          word.word = text;
+          word.start = std::round((time_offset + std::any_cast<float>(timing["start"])) * 100) / 100;
+          word.end = std::round((time_offset + std::any_cast<float>(timing["end"])) * 100) / 100;
+          word.probability = std::any_cast<float>(timing["probability"]);
+          words.push_back(word);
+        }
+        saved_tokens += std::any_cast<const std::vector<int> &>(timing["tokens"]).size();
+        word_index++;
+      }
+
+      // Keep the first and last words within sensible bounds of the
+      // segment timestamps (Python line 1617-1653)
+      if (!words.empty()) {
+        float segment_start = std::any_cast<float>(subsegment["start"]);
+        float segment_end = std::any_cast<float>(subsegment["end"]);
+        clamp_segment_words(words, segment_start, segment_end, median_duration, max_duration, last_speech_timestamp);
+        subsegment["start"] = segment_start;
+        subsegment["end"] = segment_end;
+        last_speech_timestamp = segment_end;
       }
-      auto timing_tokens = std::any_cast<std::vector<int>>(timing["tokens"]);
-      saved_tokens += static_cast<int>(timing_tokens.size());
-      word_index++;
+      subsegment["words"] = words;
     }
-    subsegment["words"] = words;
-    if (!words.empty()) last_speech_timestamp = std::any_cast<float>(words.back().at("end"));
-  }
   }
 
   return last_speech_timestamp;
@@ -1493,27 +2252,44 @@ WhisperModel::find_alignment(
     results.push_back(future.get());
   }
 
+  // CTranslate2 runs the cross-attention, median filter and DTW; the path is
+  // turned into word times and probabilities here (Python line 1665-1700)
   for (size_t i = 0; i < results.size(); ++i) {
-  const auto &result = results[i];
-  const auto &tokens = text_tokens[i];
-  auto [words, word_tokens] = tokenizer.split_to_word_tokens(tokens);
-  if (word_tokens.size() <= 1) {
-    return_list.push_back({});
-    continue;
-  }
+    const auto &result = results[i];
+    auto [words, word_tokens] = tokenizer.split_to_word_tokens(text_tokens[i]);
 
-  // Construct alignment
-  std::vector<std::map<std::string, std::any>> alignment_list;
-  for (size_t j = 0; j < words.size(); ++j) {
-    alignment_list.push_back({
-               {"word",        words[j]},
-               {"tokens",      word_tokens[j]},
-               {"start",       0.0f},  // placeholder, compute from result
-               {"end",         0.0f},    // placeholder, compute from result
-               {"probability", 1.0f}  // placeholder
-           });
-  }
-  return_list.push_back(alignment_list);
+    std::vector<size_t> word_token_counts;
+    for (const auto &tokens : word_tokens) {
+      word_token_counts.push_back(tokens.size());
+    }
+    auto word_times = alignment_word_times(result.alignments, word_token_counts, static_cast<float>(time_precision));
+    if (words.empty() || word_times.empty()) {
+      return_list.push_back({});
+      continue;
+    }
+
+    std::vector<std::map<std::string, std::any>> alignment_list;
+    size_t word_start = 0;
+    for (size_t j = 0; j < words.size(); ++j) {
+      size_t word_end = word_start + word_tokens[j].size();
+
+      float probability = 0.0f;
+      size_t count = 0;
+      for (size_t k = word_start; k < word_end && k < result.text_token_probs.size(); ++k) {
+        probability += result.text_token_probs[k];
+        ++count;
+      }
+
+      alignment_list.push_back({
+        {"word",        words[j]},
+        {"tokens",      word_tokens[j]},
+        {"start",       word_times[j].first},
+        {"end",         word_times[j].second},
+        {"probability", count > 0 ? probability / count : 0.0f}
+      });
+      word_start = word_end;
+    }
+    return_list.push_back(alignment_list);
   }
 
   return return_list;
@@ -1524,11 +2300,15 @@ WhisperModel::detect_language(
   const std::vector<float> *audio,
   const std::vector<std::vector<float>> *features,
   int language_detection_segments,
-  float language_detection_threshold
+  float language_detection_threshold,
+  EncoderCache *encoder_cache,
+  int max_window_frames
 ) {
   assert(audio != nullptr || features != nullptr);
 
-  std::vector<std::vector<float>> input_features;
+  // Windows are sliced from the features directly instead of a truncated copy
+  std::vector<std::vector<float>> extracted_features;
+  const std::vector<std::vector<float>> *input_features = features;
 
   if (audio != nullptr) {
   std::vector<float> processed_audio = *audio;
@@ -1538,15 +2318,13 @@ WhisperModel::detect_language(
     processed_audio.resize(language_detection_segments * n_samples);
   }
 
-  input_features = feature_extractor.extract(processed_audio);
-  } else if (features != nullptr) {
-  input_features = *features;
+  extracted_features = feature_extractor.extract(processed_audio);
+  input_features = &extracted_features;
   }
 
   size_t max_frames = feature_extractor.nb_max_frames();
-  if (input_features[0].size() > static_cast<size_t>(language_detection_segments * max_frames)) {
-  for (auto &row: input_features)
-    row.resize(language_detection_segments * max_frames);
+  if (max_window_frames > 0) {
+    max_frames = std::min(max_frames, static_cast<size_t>(max_window_frames));
   }
 
   std::map<std::string, std::vector<float>> detected_language_info;
@@ -1554,18 +2332,21 @@ WhisperModel::detect_language(
   std::string language;
   float language_probability = 0.0f;
 
-  for (size_t i = 0; i < input_features[0].size(); i += max_frames) {
-  std::vector<std::vector<float>> segment_features;
-  size_t end_idx = std::min(i + max_frames, input_features[0].size());
-
-  for (auto &row: input_features) {
-    std::vector<float> segment_row(row.begin() + i, row.begin() + end_idx);
-    segment_features.push_back(segment_row);
-  }
+  // Windows end before the last frame like the decoding windows of
+  // generate_segments, so the encoder outputs can be cached for decoding
+  size_t total_frames = (*input_features)[0].size();
+  size_t content_frames = std::min(total_frames > 1 ? total_frames - 1 : total_frames,
+                                   static_cast<size_t>(language_detection_segments) * max_frames);
+  for (size_t i = 0; i < content_frames; i += max_frames) {
+  int seek = static_cast<int>(i);
+  int size = static_cast<int>(std::min(max_frames, content_frames - i));
 
-  auto encoder_output = encode(pad_or_trim(segment_features));
+  auto encoder_output = encode_window(*input_features, seek, size, encoder_cache);
   auto future_results = model->detect_language(encoder_output);
   auto results = future_results[0].get(); // Get result from future
+  if (encoder_cache) {
+    encoder_cache->outputs[encoder_cache_key(seek, size)] = std::move(encoder_output);
+  }
 
   // strip markers from token
   all_language_probs.clear();
@@ -1651,22 +2432,31 @@ pad_or_trim(const std::vector<std::vector<float>> &segment) {
 ctranslate2::StorageView get_ctranslate2_storage_3d(const std::vector<std::vector<float>> &features) {
   // Create 3D tensor with batch dimension: [batch_size=1, n_mels, n_frames]
   // Input features are 2D: [n_mels, n_frames]
+  return get_ctranslate2_storage_3d(std::vector<std::vector<std::vector<float>>>{features});
+}
 
-  if (features.empty() || features[0].empty()) {
+ctranslate2::StorageView get_ctranslate2_storage_3d(const std::vector<std::vector<std::vector<float>>> &batch_features) {
+  // Stack equally sized [n_mels, n_frames] windows into [batch_size, n_mels, n_frames]
+
+  if (batch_features.empty() || batch_features[0].empty() || batch_features[0][0].empty()) {
     throw std::runtime_error("Cannot create storage from empty features");
   }
 
-  size_t n_mels = features.size();
-  size_t n_frames = features[0].size();
-  size_t batch_size = 1;
+  size_t n_mels = batch_features[0].size();
+  size_t n_frames = batch_features[0][0].size();
+  size_t batch_size = batch_features.size();
 
   // Flatten into contiguous memory with batch dimension
   std::vector<float> contiguous;
   contiguous.reserve(batch_size * n_mels * n_frames);
 
-  // Add batch dimension by copying features once
-  for (const auto &row : features) {
-    contiguous.insert(contiguous.end(), row.begin(), row.end());
+  for (const auto &features : batch_features) {
+    if (features.size() != n_mels || features[0].size() != n_frames) {
+      throw std::runtime_error("All batched features must have the same shape");
+    }
+    for (const auto &row : features) {
+      contiguous.insert(contiguous.end(), row.begin(), row.end());
+    }
   }
 
   // Create 3D shape: [batch_size, n_mels, n_frames]
@@ -1679,6 +2469,14 @@ ctranslate2::StorageView get_ctranslate2_storage_3d(const std::vector<std::vecto
   return ctranslate2::StorageView(shape, contiguous);
 }
 
+ctranslate2::StorageView slice_batch(const ctranslate2::StorageView &batch, long index) {
+  // Select one item of a batched tensor, keeping the batch dimension
+  ctranslate2::StorageView indices({1}, std::vector<int32_t>{static_cast<int32_t>(index)}, batch.device());
+  ctranslate2::StorageView item(batch.dtype(), batch.device());
+  ctranslate2::ops::Gather(0)(batch, indices, item);
+  return item;
+}
+
 float get_compression_ratio(const std::string &text) {
   std::vector<unsigned char> compressed(text.size() * 2);
   uLongf compressed_size = compressed.size();
@@ -1688,28 +2486,75 @@ float get_compression_ratio(const std::string &text) {
   return static_cast<float>(text.size()) / static_cast<float>(compressed_size);
 }
 
-// SpeechTimestampsMap helper class
-class SpeechTimestampsMap {
-public:
-  SpeechTimestampsMap(const std::vector<std::map<std::string, float>> &speech_chunks,
-          int sampling_rate) {
-  // TODO: implement constructor
+void merge_punctuations(
+  std::vector<std::map<std::string, std::any>> &alignment,
+  const std::string &prepended,
+  const std::string &appended
+) {
+  // Python merge_punctuations: punctuation words join their neighbours and
+  // are left empty, keeping their place for the token counts
+  auto word_of = [](std::map<std::string, std::any> &timing) -> std::string & {
+    return std::any_cast<std::string &>(timing["word"]);
+  };
+  auto tokens_of = [](std::map<std::string, std::any> &timing) -> std::vector<int> & {
+    return std::any_cast<std::vector<int> &>(timing["tokens"]);
+  };
+  auto strip = [](const std::string &word) {
+    size_t first = word.find_first_not_of(' ');
+    if (first == std::string::npos) return std::string();
+    return word.substr(first, word.find_last_not_of(' ') - first + 1);
+  };
+
+  // Merge prepended punctuations into the following word
+  if (alignment.size() >= 2) {
+    size_t i = alignment.size() - 2;
+    size_t j = alignment.size() - 1;
+    while (true) {
+      std::string &previous = word_of(alignment[i]);
+      if (!previous.empty() && previous[0] == ' ' &&
+          prepended.find(strip(previous)) != std::string::npos) {
+        word_of(alignment[j]) = previous + word_of(alignment[j]);
+        auto &following_tokens = tokens_of(alignment[j]);
+        auto &previous_tokens = tokens_of(alignment[i]);
+        following_tokens.insert(following_tokens.begin(), previous_tokens.begin(), previous_tokens.end());
+        previous.clear();
+        previous_tokens.clear();
+      } else {
+        j = i;
+      }
+      if (i == 0) break;
+      --i;
+    }
   }
 
-  int get_chunk_index(float t) const {
-  // TODO: return chunk index containing time t
-  return 0;
+  // Merge appended punctuations into the preceding word
+  for (size_t i = 0, j = 1; j < alignment.size(); ++j) {
+    std::string &previous = word_of(alignment[i]);
+    std::string &following = word_of(alignment[j]);
+    if ((previous.empty() || previous.back() != ' ') &&
+        appended.find(following) != std::string::npos) {
+      previous += following;
+      auto &previous_tokens = tokens_of(alignment[i]);
+      auto &following_tokens = tokens_of(alignment[j]);
+      previous_tokens.insert(previous_tokens.end(), following_tokens.begin(), following_tokens.end());
+      following.clear();
+      following_tokens.clear();
+    } else {
+      i = j;
+    }
   }
+}
 
-  float get_original_time(float t, int chunk_index = -1, bool is_end = false) const {
-  // TODO: map to original audio time
-  return t;
+const Segment *next_words_segment(const std::vector<Segment> &segments, size_t start) {
+  for (size_t i = start; i < segments.size(); ++i) {
+    if (segments[i].words.has_value() && !segments[i].words->empty()) return &segments[i];
   }
-};
+  return nullptr;
+}
 
 std::vector<Segment> restore_speech_timestamps(
   std::vector<Segment> segments,
-  const std::vector<std::map<std::string, float>> &speech_chunks,
+  const std::vector<SpeechChunk> &speech_chunks,
   int sampling_rate
 ) {
   SpeechTimestampsMap ts_map(speech_chunks, sampling_rate);
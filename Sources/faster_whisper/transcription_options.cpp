@@ -0,0 +1,61 @@
+///
+/// transcription_options.cpp
+/// IArabicSpeech
+///
+
+#include "transcribe.h"
+#include <stdexcept>
+
+TranscriptionOptions WhisperModel::default_options(bool multilingual) {
+  // Python defaults (line 956-989); clip_timestamps covers the whole input
+  TranscriptionOptions options;
+  options.beam_size = 5;
+  options.best_of = 5;
+  options.patience = 1.0f;
+  options.length_penalty = 1.0f;
+  options.repetition_penalty = 1.0f;  // Match Python default (was 1.1f)
+  options.no_repeat_ngram_size = 0;   // Match Python default (was 3)
+  options.log_prob_threshold = -1.0f;
+  options.no_speech_threshold = 0.6f;
+  options.compression_ratio_threshold = 2.4f;
+  options.condition_on_previous_text = true;
+  options.prompt_reset_on_temperature = 0.5f;
+  options.temperatures = {0.0f, 0.2f, 0.4f, 0.6f, 0.8f, 1.0f}; // Python default
+  options.initial_prompt = std::nullopt;
+  options.prefix = std::nullopt;
+  options.suppress_blank = true;
+  options.suppress_tokens = std::nullopt;
+  options.without_timestamps = false;
+  options.max_initial_timestamp = 1.0f;
+  options.word_timestamps = true;
+  options.prepend_punctuations = "\"'¿([{-";
+  options.append_punctuations = "\"\'.。，！？：\")}]、";
+  options.multilingual = multilingual;
+  options.max_new_tokens = std::nullopt;
+  options.clip_timestamps = std::string("0");
+  options.hallucination_silence_threshold = std::nullopt;
+  options.hotwords = std::nullopt;
+  return options;
+}
+
+TranscriptionOptions WhisperModel::latency_profile(const std::string &profile, bool multilingual) {
+  TranscriptionOptions options = default_options(multilingual);
+  if (profile == "accurate") {
+    return options;
+  }
+  if (profile == "balanced") {
+    options.beam_size = 2;
+    options.best_of = 2;
+    options.temperatures = {0.0f, 0.4f, 0.8f};
+    options.adaptive_beam = true;
+    return options;
+  }
+  if (profile == "realtime") {
+    options.beam_size = 1;
+    options.best_of = 1;
+    options.temperatures = {0.0f};
+    options.word_timestamps = false;
+    return options;
+  }
+  throw std::invalid_argument("Unknown latency profile: " + profile);
+}
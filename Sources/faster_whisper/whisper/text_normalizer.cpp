@@ -0,0 +1,199 @@
+///
+/// text_normalizer.cpp
+/// IArabicSpeech
+///
+
+#include "text_normalizer.h"
+
+#include <cstdint>
+
+namespace whisper {
+
+  namespace {
+
+    // Contextual forms of one letter in Arabic Presentation Forms-B, which
+    // lists the isolated, final, initial and medial forms of each letter in order
+    struct PresentationForms {
+      uint16_t first;
+      uint8_t count;
+      uint16_t base[2];
+    };
+
+    constexpr PresentationForms PRESENTATION_FORMS_B[] = {
+        {0xFE70, 1, {0x064B, 0}},      {0xFE71, 1, {0x0640, 0x064B}},
+        {0xFE72, 1, {0x064C, 0}},      {0xFE74, 1, {0x064D, 0}},
+        {0xFE76, 1, {0x064E, 0}},      {0xFE77, 1, {0x0640, 0x064E}},
+        {0xFE78, 1, {0x064F, 0}},      {0xFE79, 1, {0x0640, 0x064F}},
+        {0xFE7A, 1, {0x0650, 0}},      {0xFE7B, 1, {0x0640, 0x0650}},
+        {0xFE7C, 1, {0x0651, 0}},      {0xFE7D, 1, {0x0640, 0x0651}},
+        {0xFE7E, 1, {0x0652, 0}},      {0xFE7F, 1, {0x0640, 0x0652}},
+        {0xFE80, 1, {0x0621, 0}},      {0xFE81, 2, {0x0622, 0}},
+        {0xFE83, 2, {0x0623, 0}},      {0xFE85, 2, {0x0624, 0}},
+        {0xFE87, 2, {0x0625, 0}},      {0xFE89, 4, {0x0626, 0}},
+        {0xFE8D, 2, {0x0627, 0}},      {0xFE8F, 4, {0x0628, 0}},
+        {0xFE93, 2, {0x0629, 0}},      {0xFE95, 4, {0x062A, 0}},
+        {0xFE99, 4, {0x062B, 0}},      {0xFE9D, 4, {0x062C, 0}},
+        {0xFEA1, 4, {0x062D, 0}},      {0xFEA5, 4, {0x062E, 0}},
+        {0xFEA9, 2, {0x062F, 0}},      {0xFEAB, 2, {0x0630, 0}},
+        {0xFEAD, 2, {0x0631, 0}},      {0xFEAF, 2, {0x0632, 0}},
+        {0xFEB1, 4, {0x0633, 0}},      {0xFEB5, 4, {0x0634, 0}},
+        {0xFEB9, 4, {0x0635, 0}},      {0xFEBD, 4, {0x0636, 0}},
+        {0xFEC1, 4, {0x0637, 0}},      {0xFEC5, 4, {0x0638, 0}},
+        {0xFEC9, 4, {0x0639, 0}},      {0xFECD, 4, {0x063A, 0}},
+        {0xFED1, 4, {0x0641, 0}},      {0xFED5, 4, {0x0642, 0}},
+        {0xFED9, 4, {0x0643, 0}},      {0xFEDD, 4, {0x0644, 0}},
+        {0xFEE1, 4, {0x0645, 0}},      {0xFEE5, 4, {0x0646, 0}},
+        {0xFEE9, 4, {0x0647, 0}},      {0xFEED, 2, {0x0648, 0}},
+        {0xFEEF, 2, {0x0649, 0}},      {0xFEF1, 4, {0x064A, 0}},
+        {0xFEF5, 2, {0x0644, 0x0622}}, {0xFEF7, 2, {0x0644, 0x0623}},
+        {0xFEF9, 2, {0x0644, 0x0625}}, {0xFEFB, 2, {0x0644, 0x0627}},
+    };
+
+    constexpr uint32_t TATWEEL = 0x0640;
+
+    bool is_whitespace(uint32_t cp) {
+      return cp == ' ' || (cp >= 0x09 && cp <= 0x0D) || cp == 0x85 || cp == 0xA0 ||
+             cp == 0x1680 || (cp >= 0x2000 && cp <= 0x200A) || cp == 0x2028 ||
+             cp == 0x2029 || cp == 0x202F || cp == 0x205F || cp == 0x3000;
+    }
+
+    bool is_arabic_diacritic(uint32_t cp) {
+      return (cp >= 0x064B && cp <= 0x0652) || cp == 0x0670 ||
+             (cp >= 0x0610 && cp <= 0x061A) || (cp >= 0x06D6 && cp <= 0x06DC) ||
+             (cp >= 0x06DF && cp <= 0x06E4) || cp == 0x06E7 || cp == 0x06E8 ||
+             (cp >= 0x06EA && cp <= 0x06ED);
+    }
+
+    void append_utf8(std::string &out, uint32_t cp) {
+      if (cp <= 0x7F) {
+        out += static_cast<char>(cp);
+      } else if (cp <= 0x7FF) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+      } else if (cp <= 0xFFFF) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+      } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+      }
+    }
+
+    // Base letters of a presentation form, or nullptr when cp is not one
+    const uint16_t *presentation_base(uint32_t cp) {
+      static constexpr uint16_t ALEF_WASLA[2] = {0x0671, 0};
+      static constexpr uint16_t LIGATURE_ALLAH[4] = {0x0627, 0x0644, 0x0644, 0x0647};
+
+      if (cp >= 0xFE70 && cp <= 0xFEFC) {
+        for (const auto &forms: PRESENTATION_FORMS_B) {
+          if (cp >= forms.first && cp < forms.first + forms.count) {
+            return forms.base;
+          }
+        }
+      } else if (cp == 0xFB50 || cp == 0xFB51) {
+        return ALEF_WASLA;
+      } else if (cp == 0xFDF2) {
+        return LIGATURE_ALLAH;
+      }
+      return nullptr;
+    }
+
+  } // namespace
+
+  void normalize_text(std::string_view text, std::string &out, const NormalizeOptions &options) {
+    out.clear();
+    out.reserve(text.size());
+
+    bool pending_space = false;
+    size_t content_end = 0;
+
+    size_t i = 0;
+    while (i < text.size()) {
+      // Decode one UTF-8 character; a lead byte without its full run of
+      // 10xxxxxx continuation bytes passes through as itself
+      unsigned char c = static_cast<unsigned char>(text[i]);
+      uint32_t cp = c;
+      size_t char_len = 1;
+      size_t expected = (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 1;
+      if (expected > 1 && i + expected <= text.size()) {
+        uint32_t value = c & (0xFF >> (expected + 1));
+        bool valid = true;
+        for (size_t k = 1; k < expected && valid; ++k) {
+          unsigned char next = static_cast<unsigned char>(text[i + k]);
+          valid = (next & 0xC0) == 0x80;
+          value = (value << 6) | (next & 0x3F);
+        }
+        if (valid) {
+          cp = value;
+          char_len = expected;
+        }
+      }
+      std::string_view raw = text.substr(i, char_len);
+      i += char_len;
+
+      if (is_whitespace(cp)) {
+        if (options.collapse_whitespace) {
+          pending_space = true;
+        } else if (!(options.trim && out.empty())) {
+          out += raw;
+        }
+        continue;
+      }
+
+      // Presentation forms fold first so the folded harakat and tatweel can be dropped too
+      const uint16_t *base = options.fold_presentation_forms ? presentation_base(cp) : nullptr;
+      uint32_t folded[4] = {cp, 0, 0, 0};
+      size_t count = 1;
+      if (base) {
+        count = cp == 0xFDF2 ? 4 : (base[1] != 0 ? 2 : 1);
+        for (size_t k = 0; k < count; ++k) {
+          folded[k] = base[k];
+        }
+      }
+
+      for (size_t k = 0; k < count; ++k) {
+        uint32_t letter = folded[k];
+        if ((options.remove_tatweel && letter == TATWEEL) ||
+            (options.remove_diacritics && is_arabic_diacritic(letter))) {
+          continue;
+        }
+        if (pending_space) {
+          if (!(options.trim && out.empty())) {
+            out += ' ';
+          }
+          pending_space = false;
+        }
+        if (base) {
+          append_utf8(out, letter);
+        } else {
+          out += raw;
+        }
+        content_end = out.size();
+      }
+    }
+
+    if (pending_space && !options.trim) {
+      out += ' ';
+    } else if (options.trim) {
+      out.resize(content_end);
+    }
+  }
+
+  std::string normalize_text(std::string_view text, const NormalizeOptions &options) {
+    std::string out;
+    normalize_text(text, out, options);
+    return out;
+  }
+
+  NormalizeOptions arabic_folding_options() {
+    NormalizeOptions options;
+    options.fold_presentation_forms = true;
+    options.remove_tatweel = true;
+    options.remove_diacritics = true;
+    return options;
+  }
+
+} // namespace whisper
@@ -0,0 +1,47 @@
+///
+/// text_normalizer.h
+/// IArabicSpeech
+///
+
+#ifndef TEXT_NORMALIZER_H
+#define TEXT_NORMALIZER_H
+
+#include <string>
+#include <string_view>
+
+namespace whisper {
+
+/**
+ * Options for normalize_text
+ */
+struct NormalizeOptions {
+  bool collapse_whitespace = true;       // Runs of whitespace become one space
+  bool trim = true;                      // Drop leading and trailing whitespace
+  bool fold_presentation_forms = false;  // Arabic presentation forms to base letters
+  bool remove_tatweel = false;           // Drop U+0640 ARABIC TATWEEL
+  bool remove_diacritics = false;        // Drop harakat, tanween, shadda, sukun and Quranic marks
+};
+
+/**
+ * Normalize UTF-8 text in a single pass without regular expressions
+ * @param text Input text
+ * @param out Output buffer, cleared first so it can be reused across calls
+ * @param options What to normalize
+ */
+void normalize_text(std::string_view text, std::string& out,
+                    const NormalizeOptions& options = NormalizeOptions());
+
+/**
+ * Normalize UTF-8 text into a new string
+ */
+std::string normalize_text(std::string_view text,
+                           const NormalizeOptions& options = NormalizeOptions());
+
+/**
+ * Options that fold Arabic presentation forms, tatweel and diacritics
+ */
+NormalizeOptions arabic_folding_options();
+
+} // namespace whisper
+
+#endif // TEXT_NORMALIZER_H
@@ -0,0 +1,458 @@
+///
+/// vocab_cache.cpp
+/// IArabicSpeech
+///
+
+#include "vocab_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace whisper {
+
+  namespace {
+
+    constexpr char CACHE_MAGIC[8] = {'I', 'A', 'S', 'V', 'O', 'C', 'A', 'B'};
+    constexpr uint32_t CACHE_VERSION = 1;
+
+    // Give up on a bucket after this many seeds; never reached for real vocabularies
+    constexpr uint32_t MAX_SEED = 1u << 24;
+
+    struct CacheHeader {
+      char magic[8];
+      uint32_t version;
+      uint32_t num_tokens;
+      uint64_t source_size;
+      int64_t source_mtime;
+      uint32_t num_buckets;
+      uint32_t num_slots;
+      uint64_t arena_size;
+    };
+
+    uint64_t hash_token(std::string_view token, uint64_t seed) {
+      // FNV-1a with a seeded basis and a final mix so the low bits spread well
+      uint64_t h = 14695981039346656037ULL ^ (seed * 0x9E3779B97F4A7C15ULL);
+      for (unsigned char c: token) {
+        h ^= c;
+        h *= 1099511628211ULL;
+      }
+      h ^= h >> 33;
+      h *= 0xFF51AFD7ED558CCDULL;
+      h ^= h >> 33;
+      return h;
+    }
+
+    size_t cache_length(uint32_t num_tokens, uint32_t num_buckets, uint32_t num_slots,
+                        uint64_t arena_size) {
+      return sizeof(CacheHeader) +
+             (static_cast<size_t>(num_tokens) + 1) * sizeof(uint32_t) +
+             static_cast<size_t>(num_buckets) * sizeof(uint32_t) +
+             static_cast<size_t>(num_slots) * sizeof(int32_t) +
+             static_cast<size_t>(arena_size);
+    }
+
+    // Next to the vocabulary first, then in the temporary directory keyed by its path
+    std::vector<std::string> cache_paths(const std::string& vocab_file) {
+      std::vector<std::string> paths = {vocab_file + ".cache"};
+
+      std::error_code ec;
+      std::filesystem::path temp_dir = std::filesystem::temp_directory_path(ec);
+      if (!ec) {
+        std::filesystem::path absolute = std::filesystem::absolute(vocab_file, ec);
+        uint64_t key = hash_token(ec ? vocab_file : absolute.string(), 0);
+        char name[48];
+        snprintf(name, sizeof(name), "vocabulary-%016llx.cache",
+                 static_cast<unsigned long long>(key));
+        paths.push_back((temp_dir / name).string());
+      }
+      return paths;
+    }
+
+    void append_utf8(std::string& out, unsigned int codepoint) {
+      if (codepoint <= 0x7F) {
+        out += static_cast<char>(codepoint);
+      } else if (codepoint <= 0x7FF) {
+        out += static_cast<char>(0xC0 | (codepoint >> 6));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+      } else if (codepoint <= 0xFFFF) {
+        out += static_cast<char>(0xE0 | (codepoint >> 12));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+      } else {
+        out += static_cast<char>(0xF0 | (codepoint >> 18));
+        out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+      }
+    }
+
+  } // namespace
+
+  VocabCache::VocabCache(void* data, size_t length) : data_(data), length_(length) {
+    const auto* header = static_cast<const CacheHeader*>(data_);
+    num_tokens_ = header->num_tokens;
+    num_buckets_ = header->num_buckets;
+    num_slots_ = header->num_slots;
+
+    const char* cursor = static_cast<const char*>(data_) + sizeof(CacheHeader);
+    offsets_ = reinterpret_cast<const uint32_t*>(cursor);
+    cursor += (static_cast<size_t>(num_tokens_) + 1) * sizeof(uint32_t);
+    seeds_ = reinterpret_cast<const uint32_t*>(cursor);
+    cursor += static_cast<size_t>(num_buckets_) * sizeof(uint32_t);
+    slots_ = reinterpret_cast<const int32_t*>(cursor);
+    cursor += static_cast<size_t>(num_slots_) * sizeof(int32_t);
+    arena_ = cursor;
+  }
+
+  VocabCache::~VocabCache() {
+    munmap(data_, length_);
+  }
+
+  std::shared_ptr<const VocabCache> VocabCache::open(const std::string& vocab_file) {
+    std::error_code ec;
+    uint64_t source_size = std::filesystem::file_size(vocab_file, ec);
+    if (ec) {
+      return nullptr;
+    }
+    auto write_time = std::filesystem::last_write_time(vocab_file, ec);
+    if (ec) {
+      return nullptr;
+    }
+    int64_t source_mtime = static_cast<int64_t>(write_time.time_since_epoch().count());
+
+    // Only the cache next to the vocabulary may be shared; the one in the
+    // shared temporary directory is private to the user who wrote it
+    std::vector<std::string> paths = cache_paths(vocab_file);
+    for (size_t i = 0; i < paths.size(); ++i) {
+      if (auto cache = map(paths[i], source_size, source_mtime, i > 0)) {
+        return cache;
+      }
+    }
+
+    // First run or vocabulary.json changed: parse it once and compile the cache
+    std::ifstream file(vocab_file, std::ios::binary);
+    if (!file.is_open()) {
+      return nullptr;
+    }
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::vector<std::string> tokens = parse_vocab_json(content);
+    if (tokens.empty()) {
+      return nullptr;
+    }
+
+    for (size_t i = 0; i < paths.size(); ++i) {
+      if (compile(tokens, paths[i], source_size, source_mtime, i > 0)) {
+        if (auto cache = map(paths[i], source_size, source_mtime, i > 0)) {
+          return cache;
+        }
+      }
+    }
+    return nullptr;
+  }
+
+  bool VocabCache::compile(const std::vector<std::string>& tokens,
+                           const std::string& cache_path,
+                           uint64_t source_size,
+                           int64_t source_mtime,
+                           bool owner_only) {
+    uint32_t num_tokens = static_cast<uint32_t>(tokens.size());
+
+    std::vector<uint32_t> offsets(num_tokens + 1, 0);
+    for (uint32_t i = 0; i < num_tokens; ++i) {
+      offsets[i + 1] = offsets[i] + static_cast<uint32_t>(tokens[i].size());
+    }
+    uint64_t arena_size = offsets[num_tokens];
+
+    // Index unique strings only; like the hash maps it replaces, the last id wins
+    std::unordered_map<std::string_view, int32_t> unique_ids;
+    unique_ids.reserve(num_tokens);
+    for (uint32_t i = 0; i < num_tokens; ++i) {
+      unique_ids[tokens[i]] = static_cast<int32_t>(i);
+    }
+
+    uint32_t num_keys = static_cast<uint32_t>(unique_ids.size());
+    uint32_t num_buckets = std::max<uint32_t>(1, num_keys / 4);
+    uint32_t num_slots = std::max<uint32_t>(1, num_keys + num_keys / 4);
+
+    std::vector<std::vector<int32_t>> buckets(num_buckets);
+    for (const auto& [token, id]: unique_ids) {
+      buckets[hash_token(token, 0) % num_buckets].push_back(id);
+    }
+
+    // Place the largest buckets first, each with the first seed that lands all
+    // of its keys on distinct free slots
+    std::vector<uint32_t> order(num_buckets);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+      return buckets[a].size() > buckets[b].size();
+    });
+
+    std::vector<uint32_t> seeds(num_buckets, 0);
+    std::vector<int32_t> slots(num_slots, -1);
+    std::vector<uint32_t> positions;
+
+    for (uint32_t b: order) {
+      const auto& keys = buckets[b];
+      if (keys.empty()) {
+        break;
+      }
+
+      bool placed = false;
+      for (uint32_t seed = 1; seed < MAX_SEED && !placed; ++seed) {
+        positions.clear();
+        placed = true;
+        for (int32_t id: keys) {
+          uint32_t slot = static_cast<uint32_t>(hash_token(tokens[id], seed) % num_slots);
+          if (slots[slot] != -1 ||
+              std::find(positions.begin(), positions.end(), slot) != positions.end()) {
+            placed = false;
+            break;
+          }
+          positions.push_back(slot);
+        }
+        if (placed) {
+          seeds[b] = seed;
+          for (size_t k = 0; k < keys.size(); ++k) {
+            slots[positions[k]] = keys[k];
+          }
+        }
+      }
+      if (!placed) {
+        return false;
+      }
+    }
+
+    CacheHeader header{};
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.num_tokens = num_tokens;
+    header.source_size = source_size;
+    header.source_mtime = source_mtime;
+    header.num_buckets = num_buckets;
+    header.num_slots = num_slots;
+    header.arena_size = arena_size;
+
+    std::string arena;
+    arena.reserve(arena_size);
+    for (const auto& token: tokens) {
+      arena += token;
+    }
+
+    // Write to a private file and rename it so concurrent workers never map a
+    // partial cache. The file is created fresh, never through an existing link
+    std::string temp_path = cache_path + ".tmp" + std::to_string(getpid());
+    std::remove(temp_path.c_str());
+    int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW, owner_only ? 0600 : 0644);
+    if (fd < 0) {
+      return false;
+    }
+    auto write_all = [fd](const void* data, size_t size) {
+      const char* cursor = static_cast<const char*>(data);
+      while (size > 0) {
+        ssize_t written = ::write(fd, cursor, size);
+        if (written <= 0) {
+          return false;
+        }
+        cursor += written;
+        size -= static_cast<size_t>(written);
+      }
+      return true;
+    };
+    bool written = write_all(&header, sizeof(header)) &&
+                   write_all(offsets.data(), offsets.size() * sizeof(uint32_t)) &&
+                   write_all(seeds.data(), seeds.size() * sizeof(uint32_t)) &&
+                   write_all(slots.data(), slots.size() * sizeof(int32_t)) &&
+                   write_all(arena.data(), arena.size());
+    if (close(fd) != 0 || !written) {
+      std::remove(temp_path.c_str());
+      return false;
+    }
+
+    if (std::rename(temp_path.c_str(), cache_path.c_str()) != 0) {
+      std::remove(temp_path.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  std::shared_ptr<const VocabCache> VocabCache::map(const std::string& cache_path,
+                                                    uint64_t source_size,
+                                                    int64_t source_mtime,
+                                                    bool owner_only) {
+    int fd = ::open(cache_path.c_str(), O_RDONLY | (owner_only ? O_NOFOLLOW : 0));
+    if (fd < 0) {
+      return nullptr;
+    }
+
+    // A private cache written by another user may have been planted
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(CacheHeader) ||
+        (owner_only && st.st_uid != geteuid())) {
+      close(fd);
+      return nullptr;
+    }
+
+    size_t length = static_cast<size_t>(st.st_size);
+    void* data = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+      return nullptr;
+    }
+
+    const auto* header = static_cast<const CacheHeader*>(data);
+    bool valid = std::memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 &&
+                 header->version == CACHE_VERSION &&
+                 header->source_size == source_size &&
+                 header->source_mtime == source_mtime &&
+                 header->num_buckets > 0 && header->num_slots > 0 &&
+                 cache_length(header->num_tokens, header->num_buckets, header->num_slots,
+                              header->arena_size) == length;
+    if (!valid) {
+      munmap(data, length);
+      return nullptr;
+    }
+
+    // Offsets must slice the arena in order and every slot must name a token,
+    // so lookups never read outside the mapping
+    std::shared_ptr<const VocabCache> cache(new VocabCache(data, length));
+    if (cache->offsets_[0] != 0 || cache->offsets_[cache->num_tokens_] != header->arena_size) {
+      return nullptr;
+    }
+    for (uint32_t i = 0; i < cache->num_tokens_; ++i) {
+      if (cache->offsets_[i] > cache->offsets_[i + 1]) {
+        return nullptr;
+      }
+    }
+    for (uint32_t i = 0; i < cache->num_slots_; ++i) {
+      int32_t id = cache->slots_[i];
+      if (id < -1 || (id >= 0 && static_cast<uint32_t>(id) >= cache->num_tokens_)) {
+        return nullptr;
+      }
+    }
+    return cache;
+  }
+
+  std::string_view VocabCache::token(int id) const {
+    if (id < 0 || static_cast<uint32_t>(id) >= num_tokens_) {
+      return {};
+    }
+    return std::string_view(arena_ + offsets_[id], offsets_[id + 1] - offsets_[id]);
+  }
+
+  int VocabCache::find(std::string_view token) const {
+    if (num_tokens_ == 0) {
+      return -1;
+    }
+    uint32_t seed = seeds_[hash_token(token, 0) % num_buckets_];
+    int32_t id = slots_[hash_token(token, seed) % num_slots_];
+    if (id < 0 || this->token(id) != token) {
+      return -1;
+    }
+    return id;
+  }
+
+  std::vector<std::string> VocabCache::tokens() const {
+    std::vector<std::string> result;
+    result.reserve(num_tokens_);
+    for (uint32_t i = 0; i < num_tokens_; ++i) {
+      result.emplace_back(token(static_cast<int>(i)));
+    }
+    return result;
+  }
+
+  std::vector<std::string> parse_vocab_json(const std::string& content) {
+    std::vector<std::string> tokens;
+
+    // Simple JSON parsing: find tokens between quotes
+    size_t pos = 0;
+    while (pos < content.length()) {
+      // Find opening quote
+      pos = content.find('"', pos);
+      if (pos == std::string::npos) break;
+      pos++; // Skip opening quote
+
+      // Find closing quote, handling escape sequences
+      size_t end_pos = pos;
+      while (end_pos < content.length()) {
+        if (content[end_pos] == '"') {
+          break;
+        } else if (content[end_pos] == '\\' && end_pos + 1 < content.length()) {
+          end_pos += 2; // Skip escape sequence
+        } else {
+          end_pos++;
+        }
+      }
+      if (end_pos >= content.length()) {
+        break;
+      }
+
+      std::string unescaped_token;
+      for (size_t i = pos; i < end_pos; i++) {
+        if (content[i] != '\\' || i + 1 >= end_pos) {
+          unescaped_token += content[i];
+          continue;
+        }
+
+        char next = content[i + 1];
+        switch (next) {
+          case 'n':
+            unescaped_token += '\n';
+            i++;
+            break;
+          case 't':
+            unescaped_token += '\t';
+            i++;
+            break;
+          case 'r':
+            unescaped_token += '\r';
+            i++;
+            break;
+          case '\\':
+            unescaped_token += '\\';
+            i++;
+            break;
+          case '"':
+            unescaped_token += '"';
+            i++;
+            break;
+          case 'u':
+            // Parse Unicode escape sequence \uXXXX
+            if (i + 5 < end_pos) {
+              try {
+                unsigned int codepoint = std::stoul(content.substr(i + 2, 4), nullptr, 16);
+                append_utf8(unescaped_token, codepoint);
+              } catch (...) {
+                // If parsing fails, keep the escape sequence as-is
+                unescaped_token += content.substr(i, 6);
+              }
+              i += 5; // Skip \uXXXX
+            } else {
+              // Not enough characters for full escape sequence
+              unescaped_token += content[i];
+            }
+            break;
+          default:
+            unescaped_token += content[i];
+            break;
+        }
+      }
+
+      tokens.push_back(std::move(unescaped_token));
+      pos = end_pos + 1;
+    }
+
+    return tokens;
+  }
+
+} // namespace whisper
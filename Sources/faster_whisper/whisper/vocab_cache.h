@@ -0,0 +1,105 @@
+///
+/// vocab_cache.h
+/// IArabicSpeech
+///
+
+#ifndef VOCAB_CACHE_H
+#define VOCAB_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace whisper {
+
+/**
+ * Read-only vocabulary compiled from vocabulary.json into a binary file that
+ * is mmapped instead of parsed. The file holds a header, an offset table, a
+ * hash-and-displace perfect hash index and a string arena:
+ *
+ *   header | offsets[n + 1] | seeds[buckets] | slots[slots] | arena
+ *
+ * The header records the size and modification time of the source file, so
+ * a cache compiled from an older vocabulary.json is ignored and rebuilt. A
+ * file whose offsets or slots point outside the cache is rejected.
+ */
+class VocabCache {
+public:
+  ~VocabCache();
+  VocabCache(const VocabCache&) = delete;
+  VocabCache& operator=(const VocabCache&) = delete;
+
+  /**
+   * Map the cache for a vocabulary file, compiling it first when it is
+   * missing or stale. The cache is written next to the vocabulary, or to the
+   * temporary directory when the model directory is read-only.
+   * @param vocab_file Path to a JSON array vocabulary
+   * @return Mapped cache, nullptr when the vocabulary cannot be read or no cache can be written
+   */
+  static std::shared_ptr<const VocabCache> open(const std::string& vocab_file);
+
+  /**
+   * Write a cache for the given tokens, where a token's index is its id
+   * @param owner_only Create the file readable and writable by its owner only
+   * @return True when the cache file was written
+   */
+  static bool compile(const std::vector<std::string>& tokens,
+                      const std::string& cache_path,
+                      uint64_t source_size,
+                      int64_t source_mtime,
+                      bool owner_only = false);
+
+  /**
+   * Map an existing cache file
+   * @param owner_only Reject a file owned by another user or reached through a symlink
+   * @return Mapped cache, nullptr when missing, corrupt or compiled from another source
+   */
+  static std::shared_ptr<const VocabCache> map(const std::string& cache_path,
+                                               uint64_t source_size,
+                                               int64_t source_mtime,
+                                               bool owner_only = false);
+
+  size_t size() const { return num_tokens_; }
+
+  /**
+   * Token string for an id, empty when out of range
+   */
+  std::string_view token(int id) const;
+
+  /**
+   * Id of a token string, -1 if not found
+   */
+  int find(std::string_view token) const;
+
+  /**
+   * Copy of all tokens in id order
+   */
+  std::vector<std::string> tokens() const;
+
+private:
+  VocabCache(void* data, size_t length);
+
+  void* data_;
+  size_t length_;
+  uint32_t num_tokens_ = 0;
+  uint32_t num_buckets_ = 0;
+  uint32_t num_slots_ = 0;
+  const uint32_t* offsets_ = nullptr;
+  const uint32_t* seeds_ = nullptr;
+  const int32_t* slots_ = nullptr;
+  const char* arena_ = nullptr;
+};
+
+/**
+ * Parse a JSON array of token strings, such as vocabulary.json
+ * @param content File content
+ * @return Tokens in file order
+ */
+std::vector<std::string> parse_vocab_json(const std::string& content);
+
+} // namespace whisper
+
+#endif // VOCAB_CACHE_H
@@ -6,6 +6,7 @@
 ///
 
 #include "whisper_tokenizer.h"
+#include "text_normalizer.h"
 #include <iostream>
 
 // Define logging macros for non-Android builds
@@ -16,9 +17,11 @@
 #include <fstream>
 #include <sstream>
 #include <algorithm>
-#include <regex>
 #include <cctype>
 #include <iostream>
+#include <array>
+#include <cstdint>
+#include <queue>
 
 namespace whisper {
 
@@ -74,6 +77,154 @@ static std::unordered_map<wchar_t, uint8_t> create_unicode_to_bytes() {
 // Static maps initialized once
 static const std::unordered_map<wchar_t, uint8_t> unicode_to_bytes_map = create_unicode_to_bytes();
 
+// Flat view of unicode_to_bytes_map; every mapped codepoint is below 512
+static std::array<int16_t, 512> create_byte_decoder() {
+  std::array<int16_t, 512> decoder;
+  decoder.fill(-1);
+  for (const auto& pair : unicode_to_bytes_map) {
+    decoder[static_cast<size_t>(pair.first)] = pair.second;
+  }
+  return decoder;
+}
+
+static const std::array<int16_t, 512> byte_decoder = create_byte_decoder();
+
+// Appends the raw bytes of byte-level BPE text, one byte per UTF-8 character
+static void append_bpe_bytes(std::string &out, std::string_view bpe) {
+  size_t i = 0;
+  while (i < bpe.length()) {
+    uint32_t codepoint = 0;
+    size_t char_len = 1;
+
+    // Decode UTF-8 character to get the codepoint
+    unsigned char c = static_cast<unsigned char>(bpe[i]);
+    if ((c & 0x80) == 0) {
+      codepoint = c;
+    } else if ((c & 0xE0) == 0xC0 && i + 1 < bpe.length()) {
+      codepoint = ((c & 0x1F) << 6) | (static_cast<unsigned char>(bpe[i + 1]) & 0x3F);
+      char_len = 2;
+    } else if ((c & 0xF0) == 0xE0 && i + 2 < bpe.length()) {
+      codepoint = ((c & 0x0F) << 12) |
+                  ((static_cast<unsigned char>(bpe[i + 1]) & 0x3F) << 6) |
+                  (static_cast<unsigned char>(bpe[i + 2]) & 0x3F);
+      char_len = 3;
+    } else if ((c & 0xF8) == 0xF0 && i + 3 < bpe.length()) {
+      codepoint = ((c & 0x07) << 18) |
+                  ((static_cast<unsigned char>(bpe[i + 1]) & 0x3F) << 12) |
+                  ((static_cast<unsigned char>(bpe[i + 2]) & 0x3F) << 6) |
+                  (static_cast<unsigned char>(bpe[i + 3]) & 0x3F);
+      char_len = 4;
+    } else {
+      // Invalid UTF-8, skip this byte
+      i++;
+      continue;
+    }
+
+    // Python: byte_decoder[char] if char in byte_decoder else ord(char)
+    if (codepoint < byte_decoder.size() && byte_decoder[codepoint] >= 0) {
+      out += static_cast<char>(byte_decoder[codepoint]);
+    } else if (codepoint < 256) {
+      out += static_cast<char>(codepoint);
+    }
+
+    i += char_len;
+  }
+}
+
+// Python: text.replace('\u0120', ' '); U+0120 in UTF-8 is 0xC4 0xA0
+static void replace_bpe_spaces(std::string &text) {
+  const std::string space_token = "\xC4\xA0";
+  size_t pos = 0;
+  while ((pos = text.find(space_token, pos)) != std::string::npos) {
+    text.replace(pos, space_token.length(), " ");
+    pos += 1;
+  }
+}
+
+// Byte-level BPE symbol of every byte, as UTF-8
+static std::array<std::string, 256> create_byte_encoder() {
+  std::array<std::string, 256> encoder;
+  for (const auto& pair : create_bytes_to_unicode()) {
+    uint32_t codepoint = static_cast<uint32_t>(pair.second);
+    std::string symbol;
+    if (codepoint <= 0x7F) {
+      symbol += static_cast<char>(codepoint);
+    } else {
+      symbol += static_cast<char>(0xC0 | (codepoint >> 6));
+      symbol += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+    encoder[pair.first] = symbol;
+  }
+  return encoder;
+}
+
+static const std::array<std::string, 256> byte_encoder = create_byte_encoder();
+
+// Decodes the UTF-8 character at i; invalid bytes decode as themselves
+static uint32_t codepoint_at(const std::string &text, size_t i, size_t &char_len) {
+  unsigned char c = static_cast<unsigned char>(text[i]);
+  char_len = 1;
+  if ((c & 0xE0) == 0xC0 && i + 1 < text.length()) {
+    char_len = 2;
+    return ((c & 0x1F) << 6) | (static_cast<unsigned char>(text[i + 1]) & 0x3F);
+  }
+  if ((c & 0xF0) == 0xE0 && i + 2 < text.length()) {
+    char_len = 3;
+    return ((c & 0x0F) << 12) |
+           ((static_cast<unsigned char>(text[i + 1]) & 0x3F) << 6) |
+           (static_cast<unsigned char>(text[i + 2]) & 0x3F);
+  }
+  if ((c & 0xF8) == 0xF0 && i + 3 < text.length()) {
+    char_len = 4;
+    return ((c & 0x07) << 18) |
+           ((static_cast<unsigned char>(text[i + 1]) & 0x3F) << 12) |
+           ((static_cast<unsigned char>(text[i + 2]) & 0x3F) << 6) |
+           (static_cast<unsigned char>(text[i + 3]) & 0x3F);
+  }
+  return c;
+}
+
+// Character classes of the GPT-2 pre-tokenizer pattern:
+// 's|'t|'re|'ve|'m|'ll|'d| ?\p{L}+| ?\p{N}+| ?[^\s\p{L}\p{N}]+|\s+(?!\S)|\s+
+enum class CharClass { Space, Letter, Number, Other };
+
+static CharClass classify(uint32_t cp) {
+  if (cp < 0x80) {
+    if (cp == ' ' || (cp >= 0x09 && cp <= 0x0D)) return CharClass::Space;
+    if (std::isalpha(static_cast<int>(cp))) return CharClass::Letter;
+    if (std::isdigit(static_cast<int>(cp))) return CharClass::Number;
+    return CharClass::Other;
+  }
+  if (cp == 0x85 || cp == 0xA0 || cp == 0x1680 || (cp >= 0x2000 && cp <= 0x200A) ||
+      cp == 0x2028 || cp == 0x2029 || cp == 0x202F || cp == 0x205F || cp == 0x3000) {
+    return CharClass::Space;
+  }
+  // Arabic-Indic, extended Arabic-Indic and fullwidth digits, superscripts and fractions
+  if ((cp >= 0x0660 && cp <= 0x0669) || (cp >= 0x06F0 && cp <= 0x06F9) ||
+      (cp >= 0xFF10 && cp <= 0xFF19) || cp == 0xB2 || cp == 0xB3 || cp == 0xB9 ||
+      (cp >= 0xBC && cp <= 0xBE)) {
+    return CharClass::Number;
+  }
+  // Combining marks, including Arabic harakat, are not letters in \p{L}
+  if ((cp >= 0x0300 && cp <= 0x036F) || (cp >= 0x0610 && cp <= 0x061A) ||
+      (cp >= 0x064B && cp <= 0x065F) || cp == 0x0670 || (cp >= 0x06D6 && cp <= 0x06DC) ||
+      (cp >= 0x06DF && cp <= 0x06E4) || cp == 0x06E7 || cp == 0x06E8 ||
+      (cp >= 0x06EA && cp <= 0x06ED)) {
+    return CharClass::Other;
+  }
+  // Latin-1, Arabic and general punctuation and symbols
+  if ((cp >= 0xA1 && cp <= 0xBF && cp != 0xAA && cp != 0xB5 && cp != 0xBA) ||
+      cp == 0xD7 || cp == 0xF7 || cp == 0x060C || cp == 0x060D || cp == 0x061B ||
+      cp == 0x061E || cp == 0x061F || (cp >= 0x066A && cp <= 0x066D) || cp == 0x06D4 ||
+      (cp >= 0x2010 && cp <= 0x2027) || (cp >= 0x2030 && cp <= 0x205E) ||
+      (cp >= 0x20A0 && cp <= 0x20CF) || (cp >= 0x2190 && cp <= 0x2BFF) ||
+      (cp >= 0x3001 && cp <= 0x303F) || (cp >= 0xFF01 && cp <= 0xFF0F) ||
+      (cp >= 0xFE30 && cp <= 0xFE4F) || cp >= 0x1F000) {
+    return CharClass::Other;
+  }
+  return CharClass::Letter;
+}
+
 // Language codes to token ID mapping (matching whisper.cpp)
   static const std::unordered_map<std::string, int> LANGUAGE_TO_TOKEN = {
       {"en",  50259},
@@ -225,27 +376,49 @@ static const std::unordered_map<wchar_t, uint8_t> unicode_to_bytes_map = create_
 
     initialize_special_tokens();
     initialize_language_tokens();
+    build_decode_table();
 
     // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe",
     //                     "✅ WhisperTokenizer constructor completed");
   }
 
+  WhisperTokenizer::WhisperTokenizer(std::shared_ptr<const VocabCache> vocab_cache, bool multilingual)
+      : vocab_cache_(std::move(vocab_cache)), multilingual_(multilingual) {
+
+    initialize_special_tokens();
+    initialize_language_tokens();
+    build_decode_table();
+
+    // Fill the non-speech cache now so a tokenizer shared across requests is read-only
+    get_non_speech_tokens();
+  }
+
 #ifndef NO_CTRANSLATE2
 
   WhisperTokenizer::WhisperTokenizer(const ctranslate2::Vocabulary &vocabulary, bool multilingual)
       : multilingual_(multilingual) {
 
-    load_vocab_from_ctranslate2(vocabulary);
+    assign_ctranslate2_vocab(vocabulary);
     initialize_special_tokens();
     initialize_language_tokens();
+    build_decode_table();
+
+    // Fill the non-speech cache now so a tokenizer shared across requests is read-only
+    get_non_speech_tokens();
   }
 
   void WhisperTokenizer::load_vocab_from_ctranslate2(const ctranslate2::Vocabulary &vocabulary) {
+    assign_ctranslate2_vocab(vocabulary);
+    build_decode_table();
+  }
+
+  void WhisperTokenizer::assign_ctranslate2_vocab(const ctranslate2::Vocabulary &vocabulary) {
     // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe",
     //                     "Loading vocabulary from CTranslate2 model...");
 
     vocab_to_id_.clear();
     id_to_vocab_.clear();
+    vocab_cache_.reset();
 
     // Load all tokens from the CTranslate2 vocabulary
     size_t vocab_size = vocabulary.size();
@@ -317,6 +490,8 @@ static const std::unordered_map<wchar_t, uint8_t> unicode_to_bytes_map = create_
 
     vocab_to_id_.clear();
     id_to_vocab_.clear();
+    vocab_cache_.reset();
+    build_decode_table();
 
     if (vocab_file.empty()) {
       __android_log_print(ANDROID_LOG_DEBUG, "#transcribe",
@@ -374,120 +549,26 @@ static const std::unordered_map<wchar_t, uint8_t> unicode_to_bytes_map = create_
     }
 
     if (is_json_format) {
-      // JSON format: parse tokens from JSON array
-      std::string content;
-      file.seekg(0);
-      content.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+      // JSON format: map the compiled cache, which is built on first use and
+      // rebuilt whenever the JSON file changes
+      vocab_cache_ = VocabCache::open(successful_path);
+      if (vocab_cache_) {
+        token_id = static_cast<int>(vocab_cache_->size());
+        __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Mapped compiled vocabulary cache");
+      } else {
+        // No writable cache location: parse the JSON array into the hash maps
+        std::string content;
+        file.seekg(0);
+        content.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
 
-      __android_log_print(ANDROID_LOG_DEBUG, "#transcribe",
-                          "Loaded %zu characters, parsing JSON...", content.size());
-
-      // Simple JSON parsing: find tokens between quotes
-      size_t pos = 0;
-      token_id = 0;
-
-      while (pos < content.length()) {
-        // Find opening quote
-        pos = content.find('"', pos);
-        if (pos == std::string::npos) break;
-        pos++; // Skip opening quote
-
-        // Find closing quote, handling escape sequences
-        size_t end_pos = pos;
-        while (end_pos < content.length()) {
-          if (content[end_pos] == '"') {
-            break;
-          } else if (content[end_pos] == '\\' && end_pos + 1 < content.length()) {
-            end_pos += 2; // Skip escape sequence
-          } else {
-            end_pos++;
-          }
-        }
+        __android_log_print(ANDROID_LOG_DEBUG, "#transcribe",
+                            "Loaded %zu characters, parsing JSON...", content.size());
 
-        if (end_pos < content.length()) {
-          std::string token = content.substr(pos, end_pos - pos);
-
-          // Basic unescape for common sequences
-          std::string unescaped_token;
-          for (size_t i = 0; i < token.length(); i++) {
-            if (token[i] == '\\' && i + 1 < token.length()) {
-              char next = token[i + 1];
-              switch (next) {
-                case 'n':
-                  unescaped_token += '\n';
-                  i++;
-                  break;
-                case 't':
-                  unescaped_token += '\t';
-                  i++;
-                  break;
-                case 'r':
-                  unescaped_token += '\r';
-                  i++;
-                  break;
-                case '\\':
-                  unescaped_token += '\\';
-                  i++;
-                  break;
-                case '"':
-                  unescaped_token += '"';
-                  i++;
-                  break;
-                case 'u':
-                  // Parse Unicode escape sequence \uXXXX
-                  if (i + 5 < token.length()) {
-                    std::string hex_str = token.substr(i + 2, 4);
-                    try {
-                      // Convert hex string to Unicode codepoint
-                      unsigned int codepoint = std::stoul(hex_str, nullptr, 16);
-
-                      // Convert Unicode codepoint to UTF-8 properly
-                      if (codepoint <= 0x7F) {
-                        // 1-byte UTF-8 sequence (ASCII)
-                        unescaped_token += static_cast<char>(codepoint);
-                      } else if (codepoint <= 0x7FF) {
-                        // 2-byte UTF-8 sequence
-                        unescaped_token += static_cast<char>(0xC0 | (codepoint >> 6));
-                        unescaped_token += static_cast<char>(0x80 | (codepoint & 0x3F));
-                      } else if (codepoint <= 0xFFFF) {
-                        // 3-byte UTF-8 sequence
-                        unescaped_token += static_cast<char>(0xE0 | (codepoint >> 12));
-                        unescaped_token += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
-                        unescaped_token += static_cast<char>(0x80 | (codepoint & 0x3F));
-                      } else {
-                        // 4-byte UTF-8 sequence (rare Unicode planes)
-                        unescaped_token += static_cast<char>(0xF0 | (codepoint >> 18));
-                        unescaped_token += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
-                        unescaped_token += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
-                        unescaped_token += static_cast<char>(0x80 | (codepoint & 0x3F));
-                      }
-                      i += 5; // Skip \uXXXX
-                    } catch (...) {
-                      // If parsing fails, keep the escape sequence as-is
-                      unescaped_token += token.substr(i, 6);
-                      i += 5;
-                    }
-                  } else {
-                    // Not enough characters for full escape sequence
-                    unescaped_token += token[i];
-                  }
-                  break;
-                default:
-                  unescaped_token += token[i];
-                  break;
-              }
-            } else {
-              unescaped_token += token[i];
-            }
-          }
-
-          vocab_to_id_[unescaped_token] = token_id;
-          id_to_vocab_[token_id] = unescaped_token;
+        token_id = 0;
+        for (auto &token: parse_vocab_json(content)) {
+          vocab_to_id_[token] = token_id;
+          id_to_vocab_[token_id] = std::move(token);
           token_id++;
-
-          pos = end_pos + 1;
-        } else {
-          break;
         }
       }
     } else {
@@ -508,13 +589,14 @@ static const std::unordered_map<wchar_t, uint8_t> unicode_to_bytes_map = create_
 
     // Add a verification log for the problematic token
     if (token_id > 28814) {
-      auto it = id_to_vocab_.find(28814);
-      if (it != id_to_vocab_.end()) {
+      std::string token = id_to_token(28814);
+      if (!token.empty()) {
         __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "✅ Verification: Token 28814 = '%s'",
-                            it->second.c_str());
+                            token.c_str());
       }
     }
 
+    build_decode_table();
     return token_id > 0;
   }
 
@@ -564,232 +646,284 @@ static const std::unordered_map<wchar_t, uint8_t> unicode_to_bytes_map = create_
       return {};
     }
 
-    // Normalize text
-    std::string normalized = normalize_text(text);
-
-    // Tokenize into subwords
-    auto tokens = tokenize_text(normalized);
+    // Collapse whitespace without trimming, so a leading space still marks a word start
+    thread_local std::string normalized;
+    NormalizeOptions options;
+    options.trim = false;
+    normalize_text(text, normalized, options);
 
-    // Convert to IDs
+    // Split into GPT-2 pre-tokens and apply byte-level BPE to each
     std::vector<int> token_ids;
-    for (const auto &token: tokens) {
-      auto it = vocab_to_id_.find(token);
-      if (it != vocab_to_id_.end()) {
-        token_ids.push_back(it->second);
-      } else {
-        // Handle unknown tokens - split into characters
-        for (char c: token) {
-          auto char_it = vocab_to_id_.find(std::string(1, c));
-          if (char_it != vocab_to_id_.end()) {
-            token_ids.push_back(char_it->second);
-          }
-        }
-      }
+    for (const auto &word: tokenize_text(normalized)) {
+      std::vector<int> word_ids = bpe_encode(word);
+      token_ids.insert(token_ids.end(), word_ids.begin(), word_ids.end());
     }
 
     return token_ids;
   }
 
-  std::string
-  WhisperTokenizer::decode(const std::vector<int> &tokens, bool skip_special_tokens) const {
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe",
-    //                     "🔍 WhisperTokenizer::decode() called with %zu tokens, skip_special=%d",
-    //                     tokens.size(), skip_special_tokens);
-
-    // First pass: collect all raw BPE tokens
-    std::string raw_bpe;
-
-    for (size_t i = 0; i < tokens.size(); ++i) {
-      int token_id = tokens[i];
-      // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Processing token %zu/%zu: ID=%d",
-      //                     i + 1, tokens.size(), token_id);
-
-      auto it = id_to_vocab_.find(token_id);
-      if (it != id_to_vocab_.end()) {
-        const std::string &token = it->second;
-
-        // Log hex bytes of the first 10 non-special tokens
-        // if (i < 10 && token_id < 50000) {
-        //   std::string hex_dump;
-        //   for (unsigned char c : token) {
-        //     char buf[8];
-        //     snprintf(buf, sizeof(buf), "0x%02X ", c);
-        //     hex_dump += buf;
-        //   }
-        //   __android_log_print(ANDROID_LOG_DEBUG, "#transcribe",
-        //                       "🔍 Token %d hex bytes: %s", token_id, hex_dump.c_str());
-        // }
-
-        // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Token %d -> '%s' (length: %zu)",
-        //                     token_id, token.c_str(), token.length());
-
-        // Skip special tokens if requested
-        if (skip_special_tokens) {
-          // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe",
-          //                     "Checking if token '%s' is special...", token.c_str());
-
-          // SAFER special token detection - avoid substr on very long strings
-          if (token.length() >= 4 && token[0] == '<' && token[1] == '|' &&
-              token[token.length() - 2] == '|' && token[token.length() - 1] == '>') {
-            // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "Skipping special token: '%s'",
-            //                     token.c_str());
-            continue;
-          }
-        }
-
-        raw_bpe += token;
-      } else {
-        // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe",
-        //                     "⚠️ Token ID %d not found in vocabulary!", token_id);
+  std::vector<int> WhisperTokenizer::bpe_encode(const std::string &word) const {
+    {
+      std::lock_guard<std::mutex> lock(bpe_cache_mutex_);
+      auto it = bpe_cache_.find(word);
+      if (it != bpe_cache_.end()) {
+        bpe_cache_order_.splice(bpe_cache_order_.begin(), bpe_cache_order_, it->second);
+        return it->second->second;
       }
     }
 
-    // Second pass: decode BPE to proper text
-    std::string result = decode_bpe(raw_bpe);
+    std::vector<int> ids = bpe_merge(word);
 
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe",
-    //                     "🎯 WhisperTokenizer::decode() COMPLETED! Final result: '%s'",
-    //                     result.c_str());
-    return result;
+    std::lock_guard<std::mutex> lock(bpe_cache_mutex_);
+    if (bpe_cache_.find(word) == bpe_cache_.end()) {
+      bpe_cache_order_.emplace_front(word, ids);
+      bpe_cache_[word] = bpe_cache_order_.begin();
+      if (bpe_cache_order_.size() > BPE_CACHE_CAPACITY) {
+        bpe_cache_.erase(bpe_cache_order_.back().first);
+        bpe_cache_order_.pop_back();
+      }
+    }
+    return ids;
   }
 
-  std::string WhisperTokenizer::decode_bpe(const std::string &raw_bpe) const {
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe", "🔧 decode_bpe() called with length: %zu",
-    //                     raw_bpe.length());
+  std::vector<int> WhisperTokenizer::bpe_merge(const std::string &word) const {
+    if (word.empty()) {
+      return {};
+    }
 
-    // Log first 40 bytes of raw_bpe as hex
-    // if (raw_bpe.length() > 0) {
-    //   std::string hex_dump;
-    //   size_t max_bytes = std::min<size_t>(40, raw_bpe.length());
-    //   for (size_t i = 0; i < max_bytes; ++i) {
-    //     char buf[8];
-    //     snprintf(buf, sizeof(buf), "%02X ", (unsigned char)raw_bpe[i]);
-    //     hex_dump += buf;
-    //   }
-    //   __android_log_print(ANDROID_LOG_DEBUG, "#transcribe",
-    //                       "📝 First %zu bytes of raw_bpe: %s", max_bytes, hex_dump.c_str());
-    // }
+    // Byte-level symbols of the word; offsets[i] is where byte i starts in encoded
+    std::string encoded;
+    std::vector<size_t> offsets;
+    offsets.reserve(word.size() + 1);
+    for (unsigned char byte: word) {
+      offsets.push_back(encoded.size());
+      encoded += byte_encoder[byte];
+    }
+    offsets.push_back(encoded.size());
 
-    // Convert unicode characters back to bytes using the mapping
-    std::vector<uint8_t> byte_list;
+    // Merge ranks are token ids; special tokens never take part in merges
+    auto rank_of = [&](int begin, int end) {
+      int id = find_token(std::string_view(encoded).substr(offsets[begin], offsets[end] - offsets[begin]));
+      return id < EOT_TOKEN ? id : -1;
+    };
 
-    // Process the raw_bpe string byte by byte (matching Python's approach)
-    // In Python, when iterating through a string with "for char in raw_bpe:",
-    // it iterates through Unicode characters, where each character represents
-    // a codepoint from the bytes_to_unicode mapping
-    size_t i = 0;
-    while (i < raw_bpe.length()) {
-      uint32_t codepoint = 0;
-      size_t char_len = 1;
-
-      // Decode UTF-8 character to get the codepoint
-      unsigned char c = static_cast<unsigned char>(raw_bpe[i]);
-      if ((c & 0x80) == 0) {
-        // 1-byte character (ASCII)
-        codepoint = c;
-      } else if ((c & 0xE0) == 0xC0 && i + 1 < raw_bpe.length()) {
-        // 2-byte character
-        codepoint = ((c & 0x1F) << 6) | (static_cast<unsigned char>(raw_bpe[i + 1]) & 0x3F);
-        char_len = 2;
-      } else if ((c & 0xF0) == 0xE0 && i + 2 < raw_bpe.length()) {
-        // 3-byte character
-        codepoint = ((c & 0x0F) << 12) |
-                    ((static_cast<unsigned char>(raw_bpe[i + 1]) & 0x3F) << 6) |
-                    (static_cast<unsigned char>(raw_bpe[i + 2]) & 0x3F);
-        char_len = 3;
-      } else if ((c & 0xF8) == 0xF0 && i + 3 < raw_bpe.length()) {
-        // 4-byte character
-        codepoint = ((c & 0x07) << 18) |
-                    ((static_cast<unsigned char>(raw_bpe[i + 1]) & 0x3F) << 12) |
-                    ((static_cast<unsigned char>(raw_bpe[i + 2]) & 0x3F) << 6) |
-                    (static_cast<unsigned char>(raw_bpe[i + 3]) & 0x3F);
-        char_len = 4;
-      } else {
-        // Invalid UTF-8, skip this byte
-        __android_log_print(ANDROID_LOG_DEBUG, "#transcribe",
-                            "⚠️ Invalid UTF-8 byte at position %zu: 0x%02X", i, c);
-        i++;
+    const int n = static_cast<int>(word.size());
+    int whole = rank_of(0, n);
+    if (whole != -1) {
+      return {whole};
+    }
+
+    // Symbols are identified by their first byte and linked in order; a merge
+    // joins a symbol with the next one and bumps the left symbol's version so
+    // queued merges that involve the old symbol are dropped when popped
+    std::vector<int> next(n), prev(n);
+    std::vector<uint32_t> version(n, 0);
+    for (int i = 0; i < n; ++i) {
+      next[i] = i + 1;
+      prev[i] = i - 1;
+    }
+
+    struct Merge {
+      int rank;
+      int left;
+      int right;
+      uint32_t left_version;
+      uint32_t right_version;
+    };
+    auto later = [](const Merge &a, const Merge &b) {
+      return a.rank > b.rank || (a.rank == b.rank && a.left > b.left);
+    };
+    std::priority_queue<Merge, std::vector<Merge>, decltype(later)> queue(later);
+
+    auto push_merge = [&](int left, int right) {
+      int rank = rank_of(left, next[right]);
+      if (rank != -1) {
+        queue.push({rank, left, right, version[left], version[right]});
+      }
+    };
+
+    for (int i = 0; i + 1 < n; ++i) {
+      push_merge(i, i + 1);
+    }
+
+    while (!queue.empty()) {
+      Merge merge = queue.top();
+      queue.pop();
+      if (next[merge.left] != merge.right || version[merge.left] != merge.left_version ||
+          version[merge.right] != merge.right_version) {
         continue;
       }
 
-      // Look up in the unicode-to-bytes mapping
-      // The Python version checks: if char in byte_decoder
-      auto it = unicode_to_bytes_map.find(static_cast<wchar_t>(codepoint));
-      if (it != unicode_to_bytes_map.end()) {
-        byte_list.push_back(it->second);
-      } else {
-        // Python version: else: byte_list.append(ord(char))
-        // If not in mapping, use the codepoint directly if it fits in a byte
-        if (codepoint < 256) {
-          byte_list.push_back(static_cast<uint8_t>(codepoint));
-          if (byte_list.size() <= 10) {
-            __android_log_print(ANDROID_LOG_DEBUG, "#transcribe",
-                                "⚠️ Codepoint U+%04X not in mapping, using byte 0x%02X directly",
-                                codepoint, static_cast<uint8_t>(codepoint));
-          }
-        } else {
-          __android_log_print(ANDROID_LOG_DEBUG, "#transcribe",
-                              "❌ Codepoint U+%04X not in mapping and > 255, skipping",
-                              codepoint);
-        }
+      next[merge.left] = next[merge.right];
+      if (next[merge.left] < n) {
+        prev[next[merge.left]] = merge.left;
       }
+      ++version[merge.left];
+      ++version[merge.right];
 
-      i += char_len;
+      if (prev[merge.left] >= 0) {
+        push_merge(prev[merge.left], merge.left);
+      }
+      if (next[merge.left] < n) {
+        push_merge(merge.left, next[merge.left]);
+      }
     }
 
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe",
-    //                     "🔧 Converted %zu UTF-8 characters to %zu bytes", raw_bpe.length(),
-    //                     byte_list.size());
-
-    // Log first 40 decoded bytes
-    // if (byte_list.size() > 0) {
-    //   std::string hex_dump;
-    //   size_t max_bytes = std::min<size_t>(40, byte_list.size());
-    //   for (size_t i = 0; i < max_bytes; ++i) {
-    //     char buf[8];
-    //     snprintf(buf, sizeof(buf), "%02X ", byte_list[i]);
-    //     hex_dump += buf;
-    //   }
-    //   __android_log_print(ANDROID_LOG_DEBUG, "#transcribe",
-    //                       "📝 First %zu decoded bytes: %s", max_bytes, hex_dump.c_str());
-    // }
+    std::vector<int> ids;
+    for (int i = 0; i < n; i = next[i]) {
+      int id = rank_of(i, next[i]);
+      if (id != -1) {
+        ids.push_back(id);
+        continue;
+      }
+      // Vocabularies without byte-level symbols (the built-in one) store raw bytes
+      for (int b = i; b < next[i]; ++b) {
+        int byte_id = find_token(std::string_view(word).substr(b, 1));
+        if (byte_id != -1) {
+          ids.push_back(byte_id);
+        }
+      }
+    }
+    return ids;
+  }
+
+  std::string
+  WhisperTokenizer::decode(const std::vector<int> &tokens, bool skip_special_tokens) const {
+    // Tokens are pre-decoded to bytes at load, so decoding copies each one into the result
+    auto in_table = [this](int token_id) {
+      return token_id >= 0 && static_cast<size_t>(token_id) + 1 < decoded_offsets_.size();
+    };
+
+    size_t length = 0;
+    for (int token_id: tokens) {
+      if (in_table(token_id)) {
+        length += decoded_offsets_[token_id + 1] - decoded_offsets_[token_id];
+      }
+    }
 
-    // Convert bytes to UTF-8 string
-    // Python: text = bytearray(byte_list).decode('utf-8', errors='replace')
     std::string result;
-    try {
-      result = std::string(reinterpret_cast<const char*>(byte_list.data()), byte_list.size());
-    } catch (...) {
-      // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe",
-      //                     "❌ Failed to convert bytes to string, using raw_bpe");
-      result = raw_bpe;
+    result.reserve(length);
+    for (int token_id: tokens) {
+      if (!in_table(token_id) || (skip_special_tokens && special_tokens_[token_id])) {
+        continue;
+      }
+      result.append(decoded_bytes_, decoded_offsets_[token_id],
+                    decoded_offsets_[token_id + 1] - decoded_offsets_[token_id]);
     }
 
-    // Replace BPE space token U+0120 with regular space
-    // Python: text = text.replace('\u0120', ' ')
-    // U+0120 in UTF-8 is: 0xC4 0xA0
-    std::string space_token = "\xC4\xA0";
-    size_t pos = 0;
-    while ((pos = result.find(space_token, pos)) != std::string::npos) {
-      result.replace(pos, space_token.length(), " ");
-      pos += 1;
+    replace_bpe_spaces(result);
+    return result;
+  }
+
+  void WhisperTokenizer::build_decode_table() {
+    size_t table_size = vocab_cache_ ? vocab_cache_->size() : 0;
+    for (const auto &[id, token]: id_to_vocab_) {
+      table_size = std::max(table_size, static_cast<size_t>(id) + 1);
     }
 
-    // __android_log_print(ANDROID_LOG_DEBUG, "#transcribe",
-    //                     "🔧 decode_bpe() result: '%s' (length: %zu)", result.c_str(),
-    //                     result.length());
+    decoded_bytes_.clear();
+    decoded_offsets_.assign(1, 0);
+    decoded_offsets_.reserve(table_size + 1);
+    special_tokens_.assign(table_size, false);
+    token_info_.assign(table_size, TokenInfo());
+
+    for (size_t id = 0; id < table_size; ++id) {
+      std::string_view token = token_view(static_cast<int>(id));
+      special_tokens_[id] = token.length() >= 4 && token[0] == '<' && token[1] == '|' &&
+                            token[token.length() - 2] == '|' && token[token.length() - 1] == '>';
+      size_t start = decoded_bytes_.size();
+      append_bpe_bytes(decoded_bytes_, token);
+      decoded_offsets_.push_back(static_cast<uint32_t>(decoded_bytes_.size()));
+      token_info_[id] = make_token_info(std::string_view(decoded_bytes_).substr(start));
+    }
+  }
 
-    return result;
+  WhisperTokenizer::TokenInfo WhisperTokenizer::make_token_info(std::string_view bytes) {
+    // Same test as Python's subword.strip() in string.punctuation, a substring match
+    static constexpr std::string_view PUNCTUATION = "!\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+
+    TokenInfo info;
+    info.leading_space = !bytes.empty() && bytes[0] == ' ';
+
+    size_t first = bytes.find_first_not_of(" \t\n\r\f\v");
+    size_t last = bytes.find_last_not_of(" \t\n\r\f\v");
+    std::string_view stripped = first == std::string_view::npos
+                                ? std::string_view()
+                                : bytes.substr(first, last - first + 1);
+    info.punctuation = PUNCTUATION.find(stripped) != std::string_view::npos;
+
+    // Find the last lead byte; the bytes after it belong to its character
+    size_t lead = bytes.size();
+    while (lead > 0 && (static_cast<unsigned char>(bytes[lead - 1]) & 0xC0) == 0x80) {
+      --lead;
+    }
+    if (lead == 0) {
+      info.utf8_tail = static_cast<int8_t>(-static_cast<int>(std::min<size_t>(bytes.size(), 127)));
+      return info;
+    }
+
+    unsigned char c = static_cast<unsigned char>(bytes[lead - 1]);
+    int char_len = (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 1;
+    int present = static_cast<int>(bytes.size() - lead) + 1;
+    info.utf8_tail = static_cast<int8_t>(std::max(0, char_len - present));
+    return info;
   }
 
   int WhisperTokenizer::token_to_id(const std::string &token) const {
     auto it = vocab_to_id_.find(token);
+    if (it != vocab_to_id_.end()) {
+      return it->second;
+    }
+    return vocab_cache_ ? vocab_cache_->find(token) : -1;
+  }
+
+  std::string_view WhisperTokenizer::token_bytes(int id) const {
+    if (id < 0 || static_cast<size_t>(id) + 1 >= decoded_offsets_.size()) {
+      return {};
+    }
+    return std::string_view(decoded_bytes_).substr(decoded_offsets_[id],
+                                                   decoded_offsets_[id + 1] - decoded_offsets_[id]);
+  }
+
+  bool WhisperTokenizer::is_special_token(int id) const {
+    return id >= 0 && static_cast<size_t>(id) < special_tokens_.size() && special_tokens_[id];
+  }
+
+  int WhisperTokenizer::find_token(std::string_view token) const {
+    if (vocab_cache_) {
+      int id = vocab_cache_->find(token);
+      if (id != -1) {
+        return id;
+      }
+    }
+    auto it = vocab_to_id_.find(std::string(token));
     return (it != vocab_to_id_.end()) ? it->second : -1;
   }
 
   std::string WhisperTokenizer::id_to_token(int id) const {
+    return std::string(token_view(id));
+  }
+
+  std::string_view WhisperTokenizer::token_view(int id) const {
     auto it = id_to_vocab_.find(id);
-    return (it != id_to_vocab_.end()) ? it->second : "";
+    if (it != id_to_vocab_.end()) {
+      return it->second;
+    }
+    return vocab_cache_ ? vocab_cache_->token(id) : std::string_view();
+  }
+
+  size_t WhisperTokenizer::vocab_size() const {
+    if (!vocab_cache_) {
+      return vocab_to_id_.size();
+    }
+    // Special tokens are usually already in the cached vocabulary
+    size_t size = vocab_cache_->size();
+    for (const auto &[token, id]: vocab_to_id_) {
+      if (vocab_cache_->find(token) == -1) {
+        ++size;
+      }
+    }
+    return size;
   }
 
   int WhisperTokenizer::get_language_token(const std::string &language_code) const {
@@ -895,83 +1029,201 @@ static const std::unordered_map<wchar_t, uint8_t> unicode_to_bytes_map = create_
   }
 
   std::pair<std::vector<std::string>, std::vector<std::vector<int>>>
-  WhisperTokenizer::split_to_word_tokens(const std::vector<int> &tokens) const {
+  WhisperTokenizer::split_tokens_on_unicode(const std::vector<int> &tokens) const {
+    // Linear scan over the token metadata: a subword ends once its bytes end
+    // on a character boundary, so no partial character is ever decoded
     std::vector<std::string> words;
     std::vector<std::vector<int>> word_tokens;
 
-    std::vector<int> current_word_tokens;
+    std::vector<int> current_tokens;
     std::string current_word;
+    int missing = 0;
+
+    auto finish_word = [&]() {
+      if (current_tokens.empty()) {
+        return;
+      }
+      replace_bpe_spaces(current_word);
+      words.push_back(std::move(current_word));
+      word_tokens.push_back(std::move(current_tokens));
+      current_word.clear();
+      current_tokens.clear();
+      missing = 0;
+    };
 
     for (int token_id: tokens) {
       if (token_id >= EOT_TOKEN) {
-        // Special token - finish current word if any
-        if (!current_word_tokens.empty()) {
-          words.push_back(current_word);
-          word_tokens.push_back(current_word_tokens);
-          current_word.clear();
-          current_word_tokens.clear();
-        }
+        // Special token - finish current word if any and stand alone
+        finish_word();
+        current_tokens.push_back(token_id);
+        current_word += token_bytes(token_id);
+        finish_word();
         continue;
       }
+      if (token_id < 0 || static_cast<size_t>(token_id) >= token_info_.size()) {
+        continue;
+      }
+
+      const TokenInfo &info = token_info_[token_id];
+      current_tokens.push_back(token_id);
+      current_word += token_bytes(token_id);
+      missing = info.utf8_tail >= 0 ? info.utf8_tail : std::max(0, missing + info.utf8_tail);
+      if (missing == 0) {
+        finish_word();
+      }
+    }
+
+    // Add final word if any, even when its last character is incomplete
+    finish_word();
 
-      std::string token_str = id_to_token(token_id);
-      if (token_str.empty()) continue;
+    return {words, word_tokens};
+  }
 
-      current_word_tokens.push_back(token_id);
-      current_word += token_str;
+  std::pair<std::vector<std::string>, std::vector<std::vector<int>>>
+  WhisperTokenizer::split_to_word_tokens(const std::vector<int> &tokens) const {
+    auto [subwords, subword_tokens] = split_tokens_on_unicode(tokens);
 
-      // Check if this completes a word (ends with space or punctuation)
-      if (!token_str.empty() && (token_str.back() == ' ' ||
-                                 std::ispunct(static_cast<unsigned char>(token_str.back())))) {
-        words.push_back(current_word);
-        word_tokens.push_back(current_word_tokens);
-        current_word.clear();
-        current_word_tokens.clear();
+    std::vector<std::string> words;
+    std::vector<std::vector<int>> word_tokens;
+    bool word_break = true;
+    for (size_t i = 0; i < subwords.size(); ++i) {
+      // Special tokens end the current word and are dropped
+      int first = subword_tokens[i].front();
+      if (first >= EOT_TOKEN) {
+        word_break = true;
+        continue;
       }
-    }
 
-    // Add final word if any
-    if (!current_word_tokens.empty()) {
-      words.push_back(current_word);
-      word_tokens.push_back(current_word_tokens);
+      // A subword holding a non-ASCII character spans tokens and is never punctuation
+      const TokenInfo &info = token_info_[first];
+      bool punctuation = subword_tokens[i].size() == 1 && info.punctuation;
+      if (info.leading_space || punctuation || word_break) {
+        word_break = false;
+        words.push_back(std::move(subwords[i]));
+        word_tokens.push_back(std::move(subword_tokens[i]));
+      } else {
+        words.back() += subwords[i];
+        word_tokens.back().insert(word_tokens.back().end(),
+                                  subword_tokens[i].begin(), subword_tokens[i].end());
+      }
     }
 
     return {words, word_tokens};
   }
 
-  std::string WhisperTokenizer::normalize_text(const std::string &text) const {
-    std::string normalized = text;
+  std::vector<std::string> WhisperTokenizer::tokenize_text(const std::string &text) const {
+    // Hand-written equivalent of the GPT-2 pre-tokenizer pattern (see classify)
+    std::vector<std::string> words;
+    size_t i = 0;
+    size_t char_len = 0;
+
+    while (i < text.length()) {
+      // Contractions: 's 't 're 've 'm 'll 'd
+      if (text[i] == '\'' && i + 1 < text.length()) {
+        char c1 = text[i + 1];
+        char c2 = i + 2 < text.length() ? text[i + 2] : '\0';
+        size_t len = 0;
+        if (c1 == 's' || c1 == 't' || c1 == 'm' || c1 == 'd') {
+          len = 2;
+        } else if ((c1 == 'r' && c2 == 'e') || (c1 == 'v' && c2 == 'e') || (c1 == 'l' && c2 == 'l')) {
+          len = 3;
+        }
+        if (len > 0) {
+          words.push_back(text.substr(i, len));
+          i += len;
+          continue;
+        }
+      }
 
-    // Basic normalization - convert to lowercase and trim
-    std::transform(normalized.begin(), normalized.end(), normalized.begin(), ::tolower);
+      size_t start = i;
+      CharClass cls = classify(codepoint_at(text, i, char_len));
+
+      // A single leading space joins the letters, digits or symbols that follow it
+      if (text[i] == ' ' && i + 1 < text.length()) {
+        size_t next_len = 0;
+        CharClass next_cls = classify(codepoint_at(text, i + 1, next_len));
+        if (next_cls != CharClass::Space) {
+          cls = next_cls;
+          i += 1;
+          codepoint_at(text, i, char_len);
+        }
+      }
 
-    // Remove extra whitespace
-    normalized = std::regex_replace(normalized, std::regex("\\s+"), " ");
+      if (cls != CharClass::Space) {
+        while (i < text.length() && classify(codepoint_at(text, i, char_len)) == cls) {
+          i += char_len;
+        }
+        words.push_back(text.substr(start, i - start));
+        continue;
+      }
 
-    // Trim leading/trailing whitespace
-    normalized.erase(0, normalized.find_first_not_of(" \\t\\n\\r"));
-    normalized.erase(normalized.find_last_not_of(" \\t\\n\\r") + 1);
+      // Whitespace run; before a non-space the last character is left for the next word
+      size_t last = i;
+      while (i < text.length() && classify(codepoint_at(text, i, char_len)) == CharClass::Space) {
+        last = i;
+        i += char_len;
+      }
+      if (i < text.length() && last > start) {
+        i = last;
+      }
+      words.push_back(text.substr(start, i - start));
+    }
 
-    return normalized;
+    return words;
   }
 
-  std::vector<std::string> WhisperTokenizer::tokenize_text(const std::string &text) const {
-    // Simple whitespace tokenization as fallback
-    // In production, you'd use proper BPE tokenization
-    std::vector<std::string> tokens;
-    std::stringstream ss(text);
-    std::string token;
-
-    while (ss >> token) {
-      // Add space prefix except for first token
-      if (!tokens.empty()) {
-        tokens.push_back(" " + token);
-      } else {
-        tokens.push_back(token);
+// StreamingDetokenizer implementation
+  StreamingDetokenizer::StreamingDetokenizer(const WhisperTokenizer &tokenizer, bool skip_special_tokens)
+      : tokenizer_(&tokenizer), skip_special_tokens_(skip_special_tokens) {}
+
+  std::string StreamingDetokenizer::push(int token) {
+    if (!(skip_special_tokens_ && tokenizer_->is_special_token(token))) {
+      pending_ += tokenizer_->token_bytes(token);
+    }
+    return take_complete();
+  }
+
+  std::string StreamingDetokenizer::push(const std::vector<int> &tokens) {
+    for (int token: tokens) {
+      if (!(skip_special_tokens_ && tokenizer_->is_special_token(token))) {
+        pending_ += tokenizer_->token_bytes(token);
       }
     }
+    return take_complete();
+  }
+
+  std::string StreamingDetokenizer::flush() {
+    std::string text;
+    text.swap(pending_);
+    replace_bpe_spaces(text);
+    return text;
+  }
 
-    return tokens;
+  void StreamingDetokenizer::reset() {
+    pending_.clear();
+  }
+
+  std::string StreamingDetokenizer::take_complete() {
+    // Find where the last character starts and hold it back if its bytes are incomplete
+    size_t complete = pending_.size();
+    size_t lowest = pending_.size() >= 4 ? pending_.size() - 4 : 0;
+    for (size_t i = pending_.size(); i > lowest; --i) {
+      unsigned char c = static_cast<unsigned char>(pending_[i - 1]);
+      if ((c & 0xC0) == 0x80) {
+        continue;
+      }
+      size_t char_len = (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 1;
+      if (i - 1 + char_len > pending_.size()) {
+        complete = i - 1;
+      }
+      break;
+    }
+
+    std::string text = pending_.substr(0, complete);
+    pending_.erase(0, complete);
+    // Complete characters only, so a U+0120 is never split between pushes
+    replace_bpe_spaces(text);
+    return text;
   }
 
 // TokenizerWrapper implementation
@@ -1000,6 +1252,12 @@ static const std::unordered_map<wchar_t, uint8_t> unicode_to_bytes_map = create_
     }
   }
 
+  TokenizerWrapper::TokenizerWrapper(std::shared_ptr<const VocabCache> vocab_cache, bool multilingual,
+                                     const std::string &language, const std::string &task)
+      : tokenizer_(std::make_unique<WhisperTokenizer>(std::move(vocab_cache), multilingual)),
+        language_(language), task_(task) {
+  }
+
 #ifndef NO_CTRANSLATE2
 
   TokenizerWrapper::TokenizerWrapper(const ctranslate2::Vocabulary &vocabulary, bool multilingual,
@@ -1085,6 +1343,10 @@ static const std::unordered_map<wchar_t, uint8_t> unicode_to_bytes_map = create_
     return result;
   }
 
+  std::vector<int> TokenizerWrapper::get_sot_sequence(const std::string &language) const {
+    return tokenizer_->get_sot_sequence(language, task_);
+  }
+
   std::vector<int> TokenizerWrapper::get_non_speech_tokens() const {
     return tokenizer_->get_non_speech_tokens();
   }
@@ -1097,11 +1359,20 @@ static const std::unordered_map<wchar_t, uint8_t> unicode_to_bytes_map = create_
     return tokenizer_->decode(tokens, true);
   }
 
+  StreamingDetokenizer TokenizerWrapper::make_detokenizer() const {
+    return StreamingDetokenizer(*tokenizer_);
+  }
+
   std::pair<std::vector<std::string>, std::vector<std::vector<int>>>
   TokenizerWrapper::split_to_word_tokens(const std::vector<int> &tokens) const {
     return tokenizer_->split_to_word_tokens(tokens);
   }
 
+  std::pair<std::vector<std::string>, std::vector<std::vector<int>>>
+  TokenizerWrapper::split_tokens_on_unicode(const std::vector<int> &tokens) const {
+    return tokenizer_->split_tokens_on_unicode(tokens);
+  }
+
   int TokenizerWrapper::get_language_token(const std::string &language_code) const {
     return tokenizer_->get_language_token(language_code);
   }
@@ -13,7 +13,11 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <optional>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <string_view>
+#include "vocab_cache.h"
 #ifndef NO_CTRANSLATE2
 #include <ctranslate2/vocabulary.h>
 #endif
@@ -46,6 +50,14 @@ public:
    */
   explicit WhisperTokenizer(const std::string& vocab_file = "", bool multilingual = true);
 
+  /**
+   * Constructor with a mapped vocabulary cache shared with other tokenizers;
+   * only the special tokens are copied into the hash maps
+   * @param vocab_cache Compiled vocabulary from VocabCache::open
+   * @param multilingual Whether to support multiple languages
+   */
+  explicit WhisperTokenizer(std::shared_ptr<const VocabCache> vocab_cache, bool multilingual = true);
+
 #ifndef NO_CTRANSLATE2
   /**
    * Constructor with CTranslate2 vocabulary
@@ -102,6 +114,20 @@ public:
    */
   std::string id_to_token(int id) const;
 
+  /**
+   * Raw bytes of a token after byte-level BPE decoding
+   * @param id Token ID
+   * @return Bytes, empty if not found; may end inside a UTF-8 character
+   */
+  std::string_view token_bytes(int id) const;
+
+  /**
+   * Check if a token is a special <|...|> token
+   * @param id Token ID
+   * @return True if special
+   */
+  bool is_special_token(int id) const;
+
   /**
    * Get special token IDs
    */
@@ -161,7 +187,7 @@ public:
    * Get vocabulary size
    * @return Total number of tokens in vocabulary
    */
-  size_t vocab_size() const { return vocab_to_id_.size(); }
+  size_t vocab_size() const;
 
   /**
    * Check if tokenizer supports multiple languages
@@ -170,28 +196,49 @@ public:
   bool is_multilingual() const { return multilingual_; }
 
   /**
-   * Split tokens into words (for word-level timestamps)
+   * Split tokens into words (for word-level timestamps). A word starts at a
+   * subword with a leading space or at punctuation; special tokens are dropped.
    * @param tokens Input tokens
    * @return Pair of (words, word_tokens)
    */
   std::pair<std::vector<std::string>, std::vector<std::vector<int>>>
   split_to_word_tokens(const std::vector<int>& tokens) const;
 
-private:
-  // BPE helper struct
-  struct PairHash {
-      size_t operator()(const std::pair<std::string, std::string>& p) const {
-      return std::hash<std::string>{}(p.first) ^ (std::hash<std::string>{}(p.second) << 1);
-      }
-  };
+  /**
+   * Split tokens into the shortest runs that decode to complete UTF-8
+   * characters; each special token is a run of its own
+   * @param tokens Input tokens
+   * @return Pair of (subwords, subword_tokens)
+   */
+  std::pair<std::vector<std::string>, std::vector<std::vector<int>>>
+  split_tokens_on_unicode(const std::vector<int>& tokens) const;
 
-  // Vocabulary mappings
+private:
+  // Vocabulary mappings; with a vocabulary cache they only hold the special tokens
   std::unordered_map<std::string, int> vocab_to_id_;
   std::unordered_map<int, std::string> id_to_vocab_;
+  std::shared_ptr<const VocabCache> vocab_cache_;
+
+  // Raw bytes of every token after byte-level BPE decoding, indexed by id
+  std::string decoded_bytes_;
+  std::vector<uint32_t> decoded_offsets_;
+  std::vector<bool> special_tokens_;
+
+  // Word-splitting properties of a token's decoded bytes, indexed by id
+  struct TokenInfo {
+    bool leading_space = false;  // Starts with a space
+    bool punctuation = false;    // Stripped bytes appear in string.punctuation
+    int8_t utf8_tail = 0;        // Bytes missing from its last character; -n for n continuation bytes only
+  };
+  std::vector<TokenInfo> token_info_;
 
-  // BPE merges
-  std::vector<std::pair<std::string, std::string>> bpe_merges_;
-  std::unordered_map<std::pair<std::string, std::string>, int, PairHash> merge_ranks_;
+  // BPE results of recently encoded words, most recent first. The rank of a
+  // merge is the id of the merged token, so no separate merge table is needed.
+  static constexpr size_t BPE_CACHE_CAPACITY = 4096;
+  using BpeCacheEntry = std::pair<std::string, std::vector<int>>;
+  mutable std::mutex bpe_cache_mutex_;
+  mutable std::list<BpeCacheEntry> bpe_cache_order_;
+  mutable std::unordered_map<std::string, std::list<BpeCacheEntry>::iterator> bpe_cache_;
 
   // Language support
   bool multilingual_;
@@ -203,12 +250,59 @@ private:
   // Helper methods
   void initialize_special_tokens();
   void initialize_language_tokens();
-  std::string decode_bpe(const std::string& raw_bpe) const;
-  std::vector<std::string> bpe_encode(const std::string& text) const;
-  std::string normalize_text(const std::string& text) const;
+#ifndef NO_CTRANSLATE2
+  void assign_ctranslate2_vocab(const ctranslate2::Vocabulary& vocabulary);
+#endif
+  std::string_view token_view(int id) const;
+  void build_decode_table();
+  static TokenInfo make_token_info(std::string_view bytes);
+  int find_token(std::string_view token) const;
+  std::vector<int> bpe_encode(const std::string& word) const;
+  std::vector<int> bpe_merge(const std::string& word) const;
   std::vector<std::string> tokenize_text(const std::string& text) const;
-  std::pair<std::string, std::string> get_pairs(const std::vector<std::string>& word) const;
-  std::vector<std::string> apply_bpe(const std::vector<std::string>& tokens) const;
+};
+
+/**
+ * Incremental detokenizer for streaming output. Tokens are pushed one at a
+ * time or in small batches and only complete UTF-8 characters are returned;
+ * the bytes of a character split across tokens are carried to the next push.
+ */
+class StreamingDetokenizer {
+public:
+  /**
+   * @param tokenizer Tokenizer whose vocabulary is decoded; must outlive this object
+   * @param skip_special_tokens Whether to drop special tokens
+   */
+  explicit StreamingDetokenizer(const WhisperTokenizer& tokenizer, bool skip_special_tokens = true);
+
+  /**
+   * Decode one more token
+   * @return Text completed by this token
+   */
+  std::string push(int token);
+
+  /**
+   * Decode more tokens
+   * @return Text completed by these tokens
+   */
+  std::string push(const std::vector<int>& tokens);
+
+  /**
+   * Return the bytes of an unfinished character, as decode() would, and reset
+   */
+  std::string flush();
+
+  /**
+   * Drop pending bytes to start a new sequence
+   */
+  void reset();
+
+private:
+  const WhisperTokenizer* tokenizer_;
+  bool skip_special_tokens_;
+  std::string pending_;
+
+  std::string take_complete();
 };
 
 /**
@@ -221,6 +315,11 @@ public:
         const std::string& task = "transcribe",
         const std::string& vocab_path = "");
 
+  TokenizerWrapper(std::shared_ptr<const VocabCache> vocab_cache,
+        bool multilingual = true,
+        const std::string& language = "en",
+        const std::string& task = "transcribe");
+
 #ifndef NO_CTRANSLATE2
   TokenizerWrapper(const ctranslate2::Vocabulary& vocabulary,
         bool multilingual = true,
@@ -238,10 +337,12 @@ public:
   int get_no_timestamps() const;
   int get_timestamp_begin() const;
   std::vector<int> get_sot_sequence() const;
+  std::vector<int> get_sot_sequence(const std::string& language) const;
   std::vector<int> get_non_speech_tokens() const;
 
   std::vector<int> encode(const std::string& text) const;
   std::string decode(const std::vector<int>& tokens) const;
+  StreamingDetokenizer make_detokenizer() const;
 
   // Add language token method
   int get_language_token(const std::string& language_code) const;
@@ -249,6 +350,9 @@ public:
   std::pair<std::vector<std::string>, std::vector<std::vector<int>>>
   split_to_word_tokens(const std::vector<int>& tokens) const;
 
+  std::pair<std::vector<std::string>, std::vector<std::vector<int>>>
+  split_tokens_on_unicode(const std::vector<int>& tokens) const;
+
   bool is_multilingual() const;
 
 private:
@@ -33,7 +33,12 @@ add_executable(whisper_model_caller whisper_model_caller.cpp
     ${FASTER_WHISPER_DIR}/feature_extractor.cpp
     ${FASTER_WHISPER_DIR}/tokenizer.cpp
     ${FASTER_WHISPER_DIR}/utils.cpp
+    ${FASTER_WHISPER_DIR}/speech_chunks.cpp
+    ${FASTER_WHISPER_DIR}/decode_checks.cpp
+    ${FASTER_WHISPER_DIR}/transcription_options.cpp
     ${FASTER_WHISPER_DIR}/whisper/whisper_tokenizer.cpp
+    ${FASTER_WHISPER_DIR}/whisper/vocab_cache.cpp
+    ${FASTER_WHISPER_DIR}/whisper/text_normalizer.cpp
     ${FASTER_WHISPER_DIR}/whisper/whisper_audio.cpp
 )
 
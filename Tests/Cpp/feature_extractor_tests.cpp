@@ -797,6 +797,60 @@ namespace {
     return true;
   }
 
+/**
+ * Test speech detection on mel frames
+ */
+  bool test_mel_speech_detection() {
+    std::cout << "\n=== Testing Mel Speech Detection ===" << std::endl;
+
+    FeatureExtractor extractor;
+    int sample_rate = 16000;
+
+    // 1.5s background, 1s burst, 2s background, 1s burst, 1s background
+    std::vector<float> audio;
+    auto append_noise = [&audio](int num_samples, float amplitude, float modulation_hz) {
+      unsigned int state = 12345u + audio.size();
+      for (int i = 0; i < num_samples; i++) {
+        state = state * 1103515245u + 12345u;
+        float noise = ((state >> 16) & 0x7fff) / 16384.0f - 1.0f;
+        float envelope = modulation_hz > 0 ? std::abs(std::sin(M_PI * modulation_hz * i / 16000.0f)) : 1.0f;
+        audio.push_back(amplitude * noise * envelope);
+      }
+    };
+    append_noise(sample_rate * 3 / 2, 0.002f, 0.0f);
+    append_noise(sample_rate, 0.3f, 3.0f);
+    append_noise(sample_rate * 2, 0.002f, 0.0f);
+    append_noise(sample_rate, 0.3f, 3.0f);
+    append_noise(sample_rate, 0.002f, 0.0f);
+
+    auto features = extractor.extract(audio);
+    auto regions = extractor.detect_speech(features);
+
+    ASSERT_EQ(regions.size(), 2, "Two speech regions detected");
+    ASSERT_APPROX_EQ(regions[0].first, 150, 30, "First region start frame");
+    ASSERT_APPROX_EQ(regions[0].second, 250, 30, "First region end frame");
+    ASSERT_APPROX_EQ(regions[1].first, 450, 30, "Second region start frame");
+    ASSERT_APPROX_EQ(regions[1].second, 550, 30, "Second region end frame");
+
+    // Digital silence has no speech at all
+    std::vector<float> zero_audio(sample_rate * 2, 0.0f);
+    auto zero_regions = extractor.detect_speech(extractor.extract(zero_audio));
+    ASSERT_TRUE(zero_regions.empty(), "Silence has no speech regions");
+
+    // A steady signal without background is kept whole
+    std::vector<float> steady_audio;
+    audio.swap(steady_audio);
+    append_noise(sample_rate * 2, 0.3f, 0.0f);
+    auto steady_features = extractor.extract(audio);
+    auto steady_regions = extractor.detect_speech(steady_features);
+    ASSERT_EQ(steady_regions.size(), 1, "Steady signal is one region");
+    ASSERT_EQ(steady_regions[0].second, static_cast<int>(steady_features[0].size()), "Steady region spans all frames");
+
+    ASSERT_TRUE(extractor.detect_speech(Matrix()).empty(), "Empty features have no regions");
+
+    return true;
+  }
+
 } // anonymous namespace
 
 /**
@@ -820,6 +874,7 @@ bool run_feature_extractor_tests() {
   all_passed &= test_chunk_boundary_effects();
   all_passed &= test_large_audio_memory_usage();
   all_passed &= test_audio_integration();
+  all_passed &= test_mel_speech_detection();
 
   std::cout << "\n=== FEATURE EXTRACTOR TEST SUMMARY ===" << std::endl;
   if (all_passed) {
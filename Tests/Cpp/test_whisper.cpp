@@ -94,6 +94,65 @@ public:
         return true;
     }
 
+    // Token stream printed by whisper_model_caller after "=== Tokens ==="
+    bool runCallerTokens(const std::string& audioFile, const std::string& extraArgs,
+                         std::string& tokens) {
+        std::string audioPath = "../assets/" + audioFile;
+        std::string command = "./whisper_model_caller " +
+                            fs::absolute(audioPath).string() + " " +
+                            modelPath + " ar " + extraArgs;
+        std::cout << "Running: " << command << std::endl;
+
+        FILE* pipe = popen(command.c_str(), "r");
+        if (!pipe) {
+            std::cerr << "Failed to run whisper_model_caller" << std::endl;
+            return false;
+        }
+
+        std::string result;
+        char buffer[256];
+        while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+            result += buffer;
+        }
+
+        if (pclose(pipe) != 0) {
+            std::cerr << "whisper_model_caller failed for: " << extraArgs << std::endl;
+            return false;
+        }
+
+        size_t marker = result.find("=== Tokens ===");
+        if (marker == std::string::npos) {
+            std::cerr << "No token stream in output" << std::endl;
+            return false;
+        }
+        tokens = result.substr(marker);
+        return true;
+    }
+
+    // Chunked decoding has to produce the same tokens as one decode call
+    bool runChunkingTest(const std::string& audioFile, bool withoutTimestamps) {
+        std::string mode = withoutTimestamps ? "1" : "0";
+        std::cout << "\n=== Testing chunked decoding: " << audioFile
+                  << (withoutTimestamps ? " (no timestamps)" : " (timestamps)") << " ===" << std::endl;
+
+        std::string unchunked;
+        std::string chunked;
+        if (!runCallerTokens(audioFile, "0 " + mode, unchunked) ||
+            !runCallerTokens(audioFile, "16 " + mode, chunked)) {
+            return false;
+        }
+
+        if (unchunked != chunked) {
+            std::cerr << "Chunked tokens differ from unchunked" << std::endl;
+            std::cerr << "Unchunked: " << unchunked << std::endl;
+            std::cerr << "Chunked: " << chunked << std::endl;
+            return false;
+        }
+
+        std::cout << "✓ Test passed!" << std::endl;
+        return true;
+    }
+
     void runAllTests() {
         std::cout << "=== Whisper Integration Tests ===" << std::endl;
         std::cout << "Model path: " << modelPath << std::endl;
@@ -113,6 +172,18 @@ public:
             passed++;
         }
 
+        // Test 3: chunked decoding keeps the timestamped token stream
+        total++;
+        if (runChunkingTest("001.wav", false)) {
+            passed++;
+        }
+
+        // Test 4: chunked decoding keeps the untimestamped token stream
+        total++;
+        if (runChunkingTest("001.wav", true)) {
+            passed++;
+        }
+
         std::cout << "\n=== Test Summary ===" << std::endl;
         std::cout << "Passed: " << passed << "/" << total << std::endl;
 
@@ -1,7 +1,9 @@
 #include "transcribe.h"
+#include "decode_checks.h"
 #include "audio.h"
 #include "feature_extractor.h"
 #include "tokenizer.h"
+#include "vocab_cache.h"
 #include <iostream>
 #include <vector>
 #include <cassert>
@@ -13,6 +15,7 @@
 #include <map>
 #include <memory>
 #include <filesystem>
+#include <set>
 
 /**
  * Comprehensive unit tests for transcribe() function
@@ -140,6 +143,24 @@ std::vector<std::vector<float>> create_test_features(size_t n_mels = 80, size_t
     return features;
 }
 
+#ifdef HAVE_CTRANSLATE2
+// Converted model shipped with the sources, relative to the build directory
+const std::string test_model_path = "../../../Sources/faster_whisper/model/whisper_ct2";
+
+// Model shared by the decoding tests; null when the model is missing
+WhisperModel *test_model() {
+    static std::unique_ptr<WhisperModel> model;
+    static bool loaded = false;
+    if (!loaded) {
+        loaded = true;
+        if (fs::exists(test_model_path + "/model.bin")) {
+            model = std::make_unique<WhisperModel>(test_model_path, "cpu", std::vector<int>{0}, "float32", 0, 1);
+        }
+    }
+    return model.get();
+}
+#endif
+
 TranscriptionOptions create_test_options() {
     TranscriptionOptions options;
     options.beam_size = 5;
@@ -320,6 +341,60 @@ bool test_transcription_options() {
     ASSERT_TRUE(!options.prepend_punctuations.empty(), "Prepend punctuations not empty");
     ASSERT_TRUE(!options.append_punctuations.empty(), "Append punctuations not empty");
 
+    // Batched decoding of independent windows
+    ASSERT_EQ(options.batch_size, 8, "Default batch size");
+
+    return true;
+}
+
+/**
+ * Test the named latency profiles against the defaults
+ */
+bool test_latency_profile() {
+    std::cout << "\n=== Testing latency_profile ===" << std::endl;
+
+    TranscriptionOptions defaults = WhisperModel::default_options(true);
+    ASSERT_EQ(defaults.beam_size, 5, "Default beam size");
+    ASSERT_EQ(defaults.best_of, 5, "Default best_of");
+    ASSERT_EQ(defaults.temperatures.size(), 6, "Default temperature schedule");
+    ASSERT_TRUE(defaults.word_timestamps, "Default word timestamps");
+    ASSERT_TRUE(!defaults.adaptive_beam, "Default full beam search");
+    ASSERT_TRUE(defaults.multilingual, "Multilingual passed through");
+
+    TranscriptionOptions accurate = WhisperModel::latency_profile("accurate", true);
+    ASSERT_EQ(accurate.beam_size, 5, "Accurate beam size");
+    ASSERT_EQ(accurate.best_of, 5, "Accurate best_of");
+    ASSERT_EQ(accurate.temperatures.size(), 6, "Accurate temperature schedule");
+    ASSERT_TRUE(accurate.word_timestamps, "Accurate word timestamps");
+    ASSERT_TRUE(!accurate.adaptive_beam, "Accurate full beam search");
+
+    TranscriptionOptions balanced = WhisperModel::latency_profile("balanced", true);
+    ASSERT_EQ(balanced.beam_size, 2, "Balanced beam size");
+    ASSERT_EQ(balanced.best_of, 2, "Balanced best_of");
+    ASSERT_EQ(balanced.temperatures.size(), 3, "Balanced temperature schedule");
+    ASSERT_APPROX_EQ(balanced.temperatures[0], 0.0f, 0.001f, "Balanced first temperature");
+    ASSERT_APPROX_EQ(balanced.temperatures[1], 0.4f, 0.001f, "Balanced second temperature");
+    ASSERT_APPROX_EQ(balanced.temperatures[2], 0.8f, 0.001f, "Balanced last temperature");
+    ASSERT_TRUE(balanced.word_timestamps, "Balanced word timestamps");
+    ASSERT_TRUE(balanced.adaptive_beam, "Balanced adaptive beam");
+
+    TranscriptionOptions realtime = WhisperModel::latency_profile("realtime", false);
+    ASSERT_EQ(realtime.beam_size, 1, "Realtime greedy");
+    ASSERT_EQ(realtime.best_of, 1, "Realtime best_of");
+    ASSERT_EQ(realtime.temperatures.size(), 1, "Realtime single temperature");
+    ASSERT_APPROX_EQ(realtime.temperatures[0], 0.0f, 0.001f, "Realtime temperature");
+    ASSERT_TRUE(!realtime.word_timestamps, "Realtime without word timestamps");
+    ASSERT_TRUE(!realtime.adaptive_beam, "Realtime has no beam to adapt");
+    ASSERT_TRUE(!realtime.multilingual, "Multilingual passed through");
+
+    bool threw = false;
+    try {
+        WhisperModel::latency_profile("fastest");
+    } catch (const std::invalid_argument &) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw, "Unknown profile throws invalid_argument");
+
     return true;
 }
 
@@ -355,6 +430,350 @@ bool test_transcription_info() {
     return true;
 }
 
+/**
+ * Test SpeechTimestampsMap restoring times of concatenated speech chunks
+ */
+bool test_speech_timestamps_map() {
+    std::cout << "\n=== Testing SpeechTimestampsMap ===" << std::endl;
+
+    // Speech at 1-3s and 5-6s of the original audio, concatenated into 0-3s
+    std::vector<SpeechChunk> chunks = {
+        {{"start", 16000.0f}, {"end", 48000.0f}},
+        {{"start", 80000.0f}, {"end", 96000.0f}}
+    };
+    SpeechTimestampsMap ts_map(chunks, 16000);
+
+    ASSERT_EQ(ts_map.get_chunk_index(0.5f), 0, "Time in first chunk");
+    ASSERT_EQ(ts_map.get_chunk_index(2.5f), 1, "Time in second chunk");
+    ASSERT_EQ(ts_map.get_chunk_index(2.0f), 1, "Chunk boundary starts next chunk");
+    ASSERT_EQ(ts_map.get_chunk_index(2.0f, true), 0, "Chunk boundary ends previous chunk");
+    ASSERT_EQ(ts_map.get_chunk_index(10.0f), 1, "Time past the end uses last chunk");
+
+    ASSERT_APPROX_EQ(ts_map.get_original_time(0.5f), 1.5f, 0.001f, "First chunk shifted by leading silence");
+    ASSERT_APPROX_EQ(ts_map.get_original_time(2.5f), 5.5f, 0.001f, "Second chunk shifted by both silences");
+    ASSERT_APPROX_EQ(ts_map.get_original_time(2.0f, -1, true), 3.0f, 0.001f, "Segment end on boundary");
+    ASSERT_APPROX_EQ(ts_map.get_original_time(2.0f), 5.0f, 0.001f, "Segment start on boundary");
+    ASSERT_APPROX_EQ(ts_map.get_original_time(1.234f, 1), 4.23f, 0.001f, "Explicit chunk index and rounding");
+
+    return true;
+}
+
+/**
+ * Test packing speech chunks into 30 s windows
+ */
+bool test_pack_speech_chunks() {
+    std::cout << "\n=== Testing pack_speech_chunks ===" << std::endl;
+
+    // Short utterances share a window until it is full
+    auto windows = pack_speech_chunks({{0, 1000}, {1500, 2500}, {3000, 4500}, {5000, 5200}}, 3000);
+    ASSERT_EQ(windows.size(), 2, "Four chunks packed into two windows");
+    ASSERT_EQ(windows[0].size(), 2, "First window holds two chunks");
+    ASSERT_EQ(windows[1].size(), 2, "Second window holds two chunks");
+    ASSERT_EQ(windows[1][0].first, 3000, "Second window starts at third chunk");
+
+    // A chunk longer than a window is cut into window-sized pieces
+    auto long_windows = pack_speech_chunks({{100, 7100}}, 3000);
+    ASSERT_EQ(long_windows.size(), 3, "Long chunk split into three windows");
+    ASSERT_EQ(long_windows[0][0].second, 3100, "First piece is a full window");
+    ASSERT_EQ(long_windows[2][0].first, 6100, "Last piece starts after two windows");
+    ASSERT_EQ(long_windows[2][0].second, 7100, "Last piece ends at chunk end");
+
+    ASSERT_TRUE(pack_speech_chunks({}, 3000).empty(), "No chunks, no windows");
+
+    return true;
+}
+
+bool test_has_repetition_loop() {
+    std::cout << "\n=== Testing has_repetition_loop ===" << std::endl;
+    const int eot = 50257;
+
+    ASSERT_TRUE(has_repetition_loop({7, 1, 2, 3, 1, 2, 3, 1, 2, 3, 1, 2, 3}, eot, 4),
+                "Trigram repeated four times is a loop");
+    ASSERT_TRUE(!has_repetition_loop({7, 1, 2, 3, 1, 2, 3, 1, 2, 3}, eot, 4),
+                "Three repeats is not a loop");
+    ASSERT_TRUE(!has_repetition_loop({1, 2, 3, 1, 2, 3, 1, 2, 4, 1, 2, 3}, eot, 4),
+                "A changed token breaks the loop");
+    ASSERT_TRUE(has_repetition_loop({5, 50400, 5, 50410, 5, 50420, 5, 50430}, eot, 4),
+                "Increasing timestamps inside the loop are ignored");
+    ASSERT_TRUE(!has_repetition_loop({5, 5, 5, 5}, eot, 1), "Fewer than two repeats never loops");
+
+    return true;
+}
+
+bool test_parse_clip_timestamps() {
+    std::cout << "\n=== Testing parse_clip_timestamps ===" << std::endl;
+
+    auto clips = parse_clip_timestamps(std::string("0, 5.5, ,10"));
+    ASSERT_EQ(clips.size(), 3, "Blank entry skipped");
+    ASSERT_APPROX_EQ(clips[1], 5.5f, 0.001f, "Spaces around a value trimmed");
+    ASSERT_APPROX_EQ(clips[2], 10.0f, 0.001f, "Value after the blank entry kept");
+
+    auto odd = parse_clip_timestamps(std::string("1,2,3"));
+    ASSERT_EQ(odd.size(), 3, "Odd count kept; the last clip runs to the end");
+
+    ASSERT_TRUE(parse_clip_timestamps(std::string("")).empty(), "Empty string, no clips");
+    ASSERT_EQ(parse_clip_timestamps(std::vector<float>{2.0f, 4.0f}).size(), 2, "List passed through");
+
+    return true;
+}
+
+bool test_is_silent_window() {
+    std::cout << "\n=== Testing is_silent_window ===" << std::endl;
+    TranscriptionOptions options = create_test_options();  // no_speech 0.6, log_prob -1.0
+
+    ASSERT_TRUE(is_silent_window(0.9f, -1.5f, options), "Likely silence with low log-prob is skipped");
+    ASSERT_TRUE(!is_silent_window(0.9f, -0.3f, options), "Confident text is kept despite no-speech");
+    ASSERT_TRUE(!is_silent_window(0.4f, -1.5f, options), "Low no-speech probability is kept");
+
+    options.log_prob_threshold = std::nullopt;
+    ASSERT_TRUE(is_silent_window(0.9f, -0.3f, options), "Without a log-prob threshold no-speech decides");
+
+    options.no_speech_threshold = std::nullopt;
+    ASSERT_TRUE(!is_silent_window(0.99f, -5.0f, options), "Without a no-speech threshold nothing is skipped");
+
+    return true;
+}
+
+bool test_segment_anomaly() {
+    std::cout << "\n=== Testing word_anomaly_score / is_segment_anomaly ===" << std::endl;
+
+    ASSERT_APPROX_EQ(word_anomaly_score({0.0f, 0.5f, " a", 0.9f}), 0.0f, 0.001f, "Likely word scores 0");
+    ASSERT_APPROX_EQ(word_anomaly_score({0.0f, 0.5f, " a", 0.1f}), 1.0f, 0.001f, "Unlikely word scores 1");
+    ASSERT_APPROX_EQ(word_anomaly_score({0.0f, 0.033f, " a", 0.9f}), 1.5f, 0.001f, "Short word scored by missing duration");
+    ASSERT_APPROX_EQ(word_anomaly_score({0.0f, 3.0f, " a", 0.9f}), 1.0f, 0.001f, "Long word scored past 2s");
+
+    Segment segment;
+    segment.words = std::vector<Word>{
+        {0.0f, 0.5f, " a", 0.9f}, {0.5f, 1.0f, " b", 0.1f}, {1.0f, 1.5f, " c", 0.1f}, {1.5f, 2.0f, " d", 0.9f}
+    };
+    ASSERT_TRUE(!is_segment_anomaly(&segment), "Score 2 over 4 words is not an anomaly");
+
+    segment.words->at(0).probability = 0.1f;
+    ASSERT_TRUE(is_segment_anomaly(&segment), "Score 3 is an anomaly");
+
+    segment.words = std::vector<Word>{{0.0f, 0.5f, " a", 0.1f}, {0.5f, 0.6f, ".", 0.1f}};
+    ASSERT_TRUE(is_segment_anomaly(&segment), "Punctuation skipped; one unlikely word averages 1");
+
+    segment.words = std::nullopt;
+    ASSERT_TRUE(!is_segment_anomaly(&segment), "Segment without words is not an anomaly");
+    ASSERT_TRUE(!is_segment_anomaly(nullptr), "No segment is not an anomaly");
+
+    return true;
+}
+
+bool test_transcription_control() {
+    std::cout << "\n=== Testing TranscriptionControl ===" << std::endl;
+
+    TranscriptionControl idle;
+    ASSERT_TRUE(!idle.should_stop(), "Fresh control does not stop");
+    ASSERT_TRUE(idle.status() == TranscriptionStatus::Completed, "Fresh control is completed");
+
+    TranscriptionControl cancelled;
+    cancelled.cancel();
+    ASSERT_TRUE(cancelled.should_stop(), "Cancelled control stops");
+    ASSERT_TRUE(cancelled.status() == TranscriptionStatus::Cancelled, "Cancel becomes the status");
+
+    TranscriptionControl expired(std::chrono::steady_clock::now() - std::chrono::seconds(1));
+    ASSERT_TRUE(expired.should_stop(), "Expired deadline stops");
+    ASSERT_TRUE(expired.status() == TranscriptionStatus::DeadlineExceeded, "Deadline becomes the status");
+    expired.cancel();
+    ASSERT_TRUE(expired.should_stop(), "Still stopped after a late cancel");
+    ASSERT_TRUE(expired.status() == TranscriptionStatus::DeadlineExceeded, "First reason is kept");
+
+    TranscriptionControl future(std::chrono::steady_clock::now() + std::chrono::hours(1));
+    ASSERT_TRUE(!future.should_stop(), "Future deadline does not stop");
+
+    return true;
+}
+
+bool test_word_alignment() {
+    std::cout << "\n=== Testing alignment_word_times / median_word_duration / clamp_segment_words ===" << std::endl;
+
+    // DTW path as (text token, time step); the path moves to a token at steps 0, 5, 10, 25, 30
+    std::vector<std::pair<ctranslate2::dim_t, ctranslate2::dim_t>> path = {
+        {0, 0}, {0, 1}, {1, 5}, {1, 6}, {2, 10}, {3, 25}, {3, 26}, {4, 30}
+    };
+    auto times = alignment_word_times(path, {1, 2, 1}, 0.02f);
+    ASSERT_EQ(times.size(), 3, "One time range per word");
+    ASSERT_APPROX_EQ(times[0].first, 0.0f, 0.001f, "First word start");
+    ASSERT_APPROX_EQ(times[0].second, 0.1f, 0.001f, "First word ends at the next token");
+    ASSERT_APPROX_EQ(times[1].first, 0.1f, 0.001f, "Two-token word start");
+    ASSERT_APPROX_EQ(times[1].second, 0.5f, 0.001f, "Two-token word end");
+    ASSERT_APPROX_EQ(times[2].second, 0.6f, 0.001f, "Last word ends at the last jump");
+    auto past_end = alignment_word_times(path, {4, 3}, 0.02f);
+    ASSERT_APPROX_EQ(past_end[1].second, 0.6f, 0.001f, "Words past the path end at the last jump");
+    ASSERT_TRUE(alignment_word_times({}, {1}, 0.02f).empty(), "Empty path, no times");
+
+    ASSERT_APPROX_EQ(median_word_duration({0.1f, 0.4f, 0.1f}), 0.1f, 0.001f, "Odd count median");
+    ASSERT_APPROX_EQ(median_word_duration({0.2f, 0.4f, 0.1f, 0.3f}), 0.25f, 0.001f, "Even count averages the middle two");
+    ASSERT_APPROX_EQ(median_word_duration({1.0f, 2.0f}), 0.7f, 0.001f, "Median capped at 0.7s");
+    ASSERT_APPROX_EQ(median_word_duration({}), 0.0f, 0.001f, "No words, zero median");
+
+    const float median = 0.2f, max_duration = 0.4f;
+
+    // A long first word after a pause is cut to max_duration
+    std::vector<Word> words = {{0.0f, 1.5f, " a", 0.9f}, {1.5f, 1.7f, " b", 0.9f}};
+    float segment_start = 1.0f, segment_end = 1.7f;
+    clamp_segment_words(words, segment_start, segment_end, median, max_duration, 0.0f);
+    ASSERT_APPROX_EQ(words[0].start, 1.1f, 0.001f, "Stretched first word starts max_duration before its end");
+    ASSERT_APPROX_EQ(segment_start, 1.1f, 0.001f, "Segment starts at the first word");
+    ASSERT_APPROX_EQ(segment_end, 1.7f, 0.001f, "Segment ends at the last word");
+
+    // A last word running past the segment end is cut at the segment end
+    words = {{2.0f, 2.2f, " a", 0.9f}, {2.2f, 3.5f, " b", 0.9f}};
+    segment_start = 2.0f, segment_end = 2.8f;
+    clamp_segment_words(words, segment_start, segment_end, median, max_duration, 1.9f);
+    ASSERT_APPROX_EQ(words.back().end, 2.8f, 0.001f, "Last word clamped to the segment end");
+    ASSERT_APPROX_EQ(segment_end, 2.8f, 0.001f, "Segment end kept");
+
+    // A first word starting well before the segment is moved to the segment start
+    words = {{0.5f, 3.0f, " a", 0.9f}, {3.0f, 3.2f, " b", 0.9f}};
+    segment_start = 2.0f, segment_end = 3.2f;
+    clamp_segment_words(words, segment_start, segment_end, median, max_duration, 2.9f);
+    ASSERT_APPROX_EQ(words[0].start, 2.0f, 0.001f, "First word clamped to the segment start");
+    ASSERT_APPROX_EQ(segment_start, 2.0f, 0.001f, "Segment start kept");
+
+    return true;
+}
+
+/**
+ * Test that transcribe() stops at a cancelled or expired control (001.wav, two windows)
+ */
+bool test_transcribe_with_control() {
+    std::cout << "\n=== Testing transcribe() with TranscriptionControl ===" << std::endl;
+#ifdef HAVE_CTRANSLATE2
+    WhisperModel *model = test_model();
+    std::string audio_file_path = "../assets/001.wav";
+    if (!model || !fs::exists(audio_file_path)) {
+        std::cout << "⚠ Model or 001.wav not found, skipping control test" << std::endl;
+        return true;
+    }
+    std::vector<float> audio = Audio::decode_audio(audio_file_path, 16000);
+    TranscriptionOptions options = WhisperModel::latency_profile("realtime", true);
+
+    TranscriptionControl cancelled;
+    cancelled.cancel();
+    auto [cancelled_segments, cancelled_info] =
+        model->transcribe(audio, options, "ar", false, MelVadOptions(), nullptr, &cancelled);
+    ASSERT_TRUE(cancelled_info.status == TranscriptionStatus::Cancelled, "Pre-cancelled status is Cancelled");
+    ASSERT_EQ(cancelled_segments.size(), 0, "Pre-cancelled transcription decodes no window");
+
+    TranscriptionControl expired(std::chrono::steady_clock::now() - std::chrono::seconds(1));
+    auto [expired_segments, expired_info] =
+        model->transcribe(audio, options, "ar", false, MelVadOptions(), nullptr, &expired);
+    ASSERT_TRUE(expired_info.status == TranscriptionStatus::DeadlineExceeded, "Expired status is DeadlineExceeded");
+    ASSERT_EQ(expired_segments.size(), 0, "Expired transcription decodes no window");
+
+    // Cancelling at the first segment finishes that window and decodes no other
+    TranscriptionControl midway;
+    auto cancel_on_first = [&midway](const Segment &, const TranscriptionProgress &) { midway.cancel(); };
+    auto [midway_segments, midway_info] =
+        model->transcribe(audio, options, "ar", false, MelVadOptions(), cancel_on_first, &midway);
+    ASSERT_TRUE(midway_info.status == TranscriptionStatus::Cancelled, "Cancelled midway status is Cancelled");
+    ASSERT_TRUE(!midway_segments.empty(), "Segments of the first window are kept");
+    ASSERT_TRUE(midway_segments.back().end <= 30.0f, "No segment past the first window");
+#else
+    std::cout << "⚠ Built without CTranslate2, skipping control test" << std::endl;
+#endif
+    return true;
+}
+
+/**
+ * Test that language detection and decoding encode each window once (001.wav, two windows)
+ */
+bool test_encoder_cache() {
+    std::cout << "\n=== Testing EncoderCache ===" << std::endl;
+#ifdef HAVE_CTRANSLATE2
+    WhisperModel *model = test_model();
+    std::string audio_file_path = "../assets/001.wav";
+    auto vocab_cache = whisper::VocabCache::open(test_model_path + "/vocabulary.json");
+    if (!model || !vocab_cache || !fs::exists(audio_file_path)) {
+        std::cout << "⚠ Model, vocabulary or 001.wav not found, skipping encoder cache test" << std::endl;
+        return true;
+    }
+    std::vector<float> audio = Audio::decode_audio(audio_file_path, 16000);
+    auto features = FeatureExtractor().extract(audio);
+    Tokenizer tokenizer(vocab_cache, true, "transcribe", "ar");
+
+    // Batched windows are fixed 30s strides: 43s gives two
+    TranscriptionOptions options = WhisperModel::latency_profile("realtime", false);
+    options.condition_on_previous_text = false;
+    EncoderCache batched_cache;
+    model->detect_language(nullptr, &features, 1, 0.5f, &batched_cache);
+    ASSERT_EQ(batched_cache.encoded_windows, 1, "Language detection encodes the first window");
+    model->generate_segments(features, tokenizer, options, &batched_cache);
+    ASSERT_EQ(batched_cache.encoded_windows, 2, "Batched decoding encodes only the second window");
+    ASSERT_TRUE(batched_cache.outputs.empty(), "Batched decoding takes the detection window");
+
+    // Sequential windows follow the timestamps; each one decoded has segments
+    options.condition_on_previous_text = true;
+    EncoderCache sequential_cache;
+    model->detect_language(nullptr, &features, 1, 0.5f, &sequential_cache);
+    auto segments = model->generate_segments(features, tokenizer, options, &sequential_cache);
+    std::set<int> window_seeks;
+    for (const auto &segment : segments) {
+        window_seeks.insert(segment.seek);
+    }
+    ASSERT_EQ(sequential_cache.encoded_windows, static_cast<int>(window_seeks.size()), "One encode per decoded window");
+    ASSERT_TRUE(sequential_cache.outputs.empty(), "Sequential decoding takes the detection window");
+#else
+    std::cout << "⚠ Built without CTranslate2, skipping encoder cache test" << std::endl;
+#endif
+    return true;
+}
+
+/**
+ * Test that transcribe_batch() matches transcribe() clip by clip (two clips of 001.wav)
+ */
+bool test_transcribe_batch_matches_transcribe() {
+    std::cout << "\n=== Testing transcribe_batch() against transcribe() ===" << std::endl;
+#ifdef HAVE_CTRANSLATE2
+    WhisperModel *model = test_model();
+    std::string audio_file_path = "../assets/001.wav";
+    if (!model || !fs::exists(audio_file_path)) {
+        std::cout << "⚠ Model or 001.wav not found, skipping batch test" << std::endl;
+        return true;
+    }
+    std::vector<float> audio = Audio::decode_audio(audio_file_path, 16000);
+    ASSERT_TRUE(audio.size() >= 16000 * 14, "001.wav holds two clips");
+
+    // Clips of different lengths, so each info.duration is its own
+    std::vector<std::vector<float>> clips = {
+        std::vector<float>(audio.begin(), audio.begin() + 16000 * 6),
+        std::vector<float>(audio.begin() + 16000 * 6, audio.begin() + 16000 * 14)
+    };
+    std::vector<AudioSpan> spans;
+    for (const auto &clip : clips) {
+        spans.push_back({clip.data(), clip.size()});
+    }
+
+    TranscriptionOptions options = WhisperModel::latency_profile("realtime", true);
+    options.condition_on_previous_text = false;
+    auto batch_results = model->transcribe_batch(spans, "ar", options);
+    ASSERT_EQ(batch_results.size(), clips.size(), "One result per clip");
+
+    auto join_text = [](const std::vector<Segment> &segments) {
+        std::string text;
+        for (const auto &segment : segments) {
+            text += segment.text;
+        }
+        return text;
+    };
+    for (size_t i = 0; i < clips.size(); ++i) {
+        auto [segments, info] = model->transcribe(clips[i], options, "ar");
+        const auto &[batch_segments, batch_info] = batch_results[i];
+        std::string clip_name = "Clip " + std::to_string(i);
+        ASSERT_TRUE(!batch_segments.empty(), clip_name + " transcribed");
+        ASSERT_EQ(join_text(batch_segments), join_text(segments), clip_name + " text matches transcribe()");
+        ASSERT_APPROX_EQ(batch_info.duration, clips[i].size() / 16000.0f, 0.001f, clip_name + " duration");
+        ASSERT_APPROX_EQ(batch_info.duration, info.duration, 0.001f, clip_name + " duration matches transcribe()");
+    }
+#else
+    std::cout << "⚠ Built without CTranslate2, skipping batch test" << std::endl;
+#endif
+    return true;
+}
+
 /**
  * Test transcribe() with real Arabic audio (Al-Fatiha - 001.wav)
  */
@@ -507,12 +926,24 @@ bool run_transcribe_tests() {
     all_passed &= test_word_structure();
     all_passed &= test_segment_structure();
     all_passed &= test_transcription_options();
+    all_passed &= test_latency_profile();
     all_passed &= test_transcription_info();
 
     // Utility function tests
     all_passed &= test_transcribe_utility_functions();
+    all_passed &= test_speech_timestamps_map();
+    all_passed &= test_pack_speech_chunks();
+    all_passed &= test_has_repetition_loop();
+    all_passed &= test_parse_clip_timestamps();
+    all_passed &= test_segment_anomaly();
+    all_passed &= test_is_silent_window();
+    all_passed &= test_transcription_control();
+    all_passed &= test_word_alignment();
 
     // Real audio transcription tests
+    all_passed &= test_transcribe_with_control();
+    all_passed &= test_transcribe_batch_matches_transcribe();
+    all_passed &= test_encoder_cache();
     all_passed &= test_alfatiha_transcription();
     all_passed &= test_wav_file_transcription();
     all_passed &= test_large_arabic_transcription();
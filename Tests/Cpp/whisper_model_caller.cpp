@@ -2,7 +2,10 @@
 /// whisper_model_caller.cpp
 /// Standalone whisper model caller for integration testing
 ///
-/// Usage: whisper_model_caller <audio_file> <model_path> [language]
+/// Usage: whisper_model_caller <audio_file> <model_path> [language] [decode_chunk_tokens [without_timestamps]]
+///
+/// With decode_chunk_tokens the greedy "realtime" profile is used, so runs
+/// that differ only in chunking can be compared token by token.
 ///
 
 #include "transcribe.h"
@@ -13,7 +16,7 @@
 
 int main(int argc, char* argv[]) {
     if (argc < 3) {
-        std::cerr << "Usage: " << argv[0] << " <audio_file> <model_path> [language]" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " <audio_file> <model_path> [language] [decode_chunk_tokens [without_timestamps]]" << std::endl;
         return 1;
     }
 
@@ -36,7 +39,13 @@ int main(int argc, char* argv[]) {
         );
 
         // Transcribe
-        auto [segments, info] = model.transcribe(audio, language, true);
+        TranscriptionOptions options = WhisperModel::default_options(true);
+        if (argc >= 5) {
+            options = WhisperModel::latency_profile("realtime", true);
+            options.decode_chunk_tokens = std::stoi(argv[4]);
+            options.without_timestamps = argc >= 6 && std::string(argv[5]) == "1";
+        }
+        auto [segments, info] = model.transcribe(audio, options, language);
 
         // Print results
         std::cout << "\n=== Transcription Results ===" << std::endl;
@@ -51,6 +60,14 @@ int main(int argc, char* argv[]) {
         }
         std::cout << std::endl;
 
+        std::cout << "\n=== Tokens ===" << std::endl;
+        for (const auto& segment : segments) {
+            for (int token : segment.tokens) {
+                std::cout << token << " ";
+            }
+        }
+        std::cout << std::endl;
+
         return 0;
 
     } catch (const std::exception& e) {
@@ -1,11 +1,14 @@
 #include "whisper_tokenizer.h"
 #include "tokenizer.h"
+#include "text_normalizer.h"
 #include <iostream>
 #include <vector>
 #include <cassert>
 #include <string>
 #include <algorithm>
 #include <fstream>  // For std::ifstream
+#include <filesystem>
+#include <stdexcept>
 
 /**
  * Unit tests for tokenizer functionality
@@ -560,6 +563,348 @@ namespace {
     return true;
   }
 
+/**
+ * Test the compiled vocabulary cache: lookups, JSON escapes and invalidation
+ */
+  bool test_vocab_cache() {
+    std::cout << "\n=== Testing Vocabulary Cache ===" << std::endl;
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "iarabicspeech_vocab_cache_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::string vocab_path = (dir / "vocabulary.json").string();
+
+    {
+      std::ofstream out(vocab_path);
+      out << "[\n  \"!\",\n  \"\\\"\",\n  \"\\u0120the\",\n  \"<|endoftext|>\"\n]\n";
+    }
+
+    auto cache = whisper::VocabCache::open(vocab_path);
+    ASSERT_TRUE(cache != nullptr, "Cache compiled on first open");
+    ASSERT_TRUE(std::filesystem::exists(vocab_path + ".cache"), "Cache written next to vocabulary");
+    ASSERT_EQ(cache->size(), 4u, "Cache has every token");
+    ASSERT_TRUE(cache->token(1) == "\"", "Escaped quote unescaped");
+    ASSERT_TRUE(cache->token(2) == "\xC4\xA0the", "Unicode escape decoded to UTF-8");
+    ASSERT_EQ(cache->find("<|endoftext|>"), 3, "Special token found");
+    ASSERT_EQ(cache->find("missing"), -1, "Unknown token not found");
+    ASSERT_TRUE(cache->token(4).empty(), "Out of range id is empty");
+
+    auto reopened = whisper::VocabCache::open(vocab_path);
+    ASSERT_TRUE(reopened != nullptr && reopened->find("!") == 0, "Existing cache mapped again");
+
+    // A changed vocabulary.json invalidates the cache
+    {
+      std::ofstream out(vocab_path);
+      out << "[\n  \"a\",\n  \"b\",\n  \"c\"\n]\n";
+    }
+    auto rebuilt = whisper::VocabCache::open(vocab_path);
+    ASSERT_TRUE(rebuilt != nullptr, "Cache rebuilt after the vocabulary changed");
+    ASSERT_EQ(rebuilt->size(), 3u, "Rebuilt cache has the new tokens");
+    ASSERT_EQ(rebuilt->find("c"), 2, "Rebuilt cache finds new token");
+    ASSERT_EQ(rebuilt->find("!"), -1, "Rebuilt cache drops old token");
+
+    // The perfect hash index resolves every token of a larger vocabulary
+    std::vector<std::string> tokens;
+    for (int i = 0; i < 20000; ++i) {
+      tokens.push_back("tok" + std::to_string(i));
+    }
+    std::string large_path = (dir / "large.cache").string();
+    ASSERT_TRUE(whisper::VocabCache::compile(tokens, large_path, 1, 2), "Large cache compiled");
+    auto large = whisper::VocabCache::map(large_path, 1, 2);
+    ASSERT_TRUE(large != nullptr, "Large cache mapped");
+    ASSERT_TRUE(whisper::VocabCache::map(large_path, 1, 3) == nullptr, "Stale source rejected");
+
+    bool all_found = true;
+    for (int i = 0; i < 20000; ++i) {
+      all_found &= large->find(tokens[i]) == i;
+    }
+    ASSERT_TRUE(all_found, "Every token maps back to its id");
+
+    // Offsets or slots pointing outside the cache reject the file. The tables
+    // follow the 48-byte header: offsets[n + 1], seeds[buckets], slots[slots]
+    std::vector<std::string> small_tokens = {"a", "bb", "ccc"};
+    const size_t header_size = 48;
+    auto patch = [](const std::string& path, size_t position, int32_t value) {
+      std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+      file.seekp(static_cast<std::streamoff>(position));
+      file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+
+    std::string offsets_path = (dir / "offsets.cache").string();
+    ASSERT_TRUE(whisper::VocabCache::compile(small_tokens, offsets_path, 1, 2), "Small cache compiled");
+    ASSERT_TRUE(whisper::VocabCache::map(offsets_path, 1, 2) != nullptr, "Small cache mapped");
+    patch(offsets_path, header_size + sizeof(uint32_t), 5);  // offsets {0, 5, 3, 6}
+    ASSERT_TRUE(whisper::VocabCache::map(offsets_path, 1, 2) == nullptr, "Offsets out of order rejected");
+    patch(offsets_path, header_size + sizeof(uint32_t), 1000);
+    ASSERT_TRUE(whisper::VocabCache::map(offsets_path, 1, 2) == nullptr, "Offset past the arena rejected");
+
+    std::string slots_path = (dir / "slots.cache").string();
+    ASSERT_TRUE(whisper::VocabCache::compile(small_tokens, slots_path, 1, 2), "Slot cache compiled");
+    size_t slots_position = header_size + (small_tokens.size() + 1) * sizeof(uint32_t) + sizeof(uint32_t);
+    patch(slots_path, slots_position, 3);  // One bucket; id 3 is past the three tokens
+    ASSERT_TRUE(whisper::VocabCache::map(slots_path, 1, 2) == nullptr, "Slot id past the tokens rejected");
+    patch(slots_path, slots_position, -7);
+    ASSERT_TRUE(whisper::VocabCache::map(slots_path, 1, 2) == nullptr, "Negative slot id rejected");
+
+    // The temporary-directory cache is private to its owner
+    std::string private_path = (dir / "private.cache").string();
+    ASSERT_TRUE(whisper::VocabCache::compile(small_tokens, private_path, 1, 2, true), "Private cache compiled");
+    auto permissions = std::filesystem::status(private_path).permissions();
+    ASSERT_TRUE((permissions & (std::filesystem::perms::group_all | std::filesystem::perms::others_all)) ==
+                std::filesystem::perms::none, "Private cache is owner-only");
+    ASSERT_TRUE(whisper::VocabCache::map(private_path, 1, 2, true) != nullptr, "Own private cache mapped");
+    std::string link_path = (dir / "link.cache").string();
+    std::filesystem::create_symlink(private_path, link_path);
+    ASSERT_TRUE(whisper::VocabCache::map(link_path, 1, 2, true) == nullptr, "Private cache through a symlink rejected");
+
+    // The tokenizer reads the cached vocabulary through its lookups
+    whisper::WhisperTokenizer tokenizer;
+    ASSERT_TRUE(tokenizer.load_vocab_from_file(vocab_path), "Tokenizer loads cached vocabulary");
+    ASSERT_EQ(tokenizer.token_to_id("b"), 1, "Tokenizer finds cached token");
+    ASSERT_EQ(tokenizer.id_to_token(2), std::string("c"), "Tokenizer returns cached token");
+
+    // Tokenizers built on a mapped cache share it instead of copying its tokens
+    whisper::WhisperTokenizer shared_tokenizer(rebuilt, true);
+    ASSERT_EQ(shared_tokenizer.token_to_id("b"), 1, "Shared-cache tokenizer finds token");
+    ASSERT_EQ(shared_tokenizer.id_to_token(2), std::string("c"), "Shared-cache tokenizer returns token");
+    ASSERT_EQ(shared_tokenizer.token_to_id("<|endoftext|>"), whisper::WhisperTokenizer::EOT_TOKEN,
+              "Shared-cache tokenizer has special tokens");
+
+    std::filesystem::remove_all(dir);
+    return true;
+  }
+
+/**
+ * Test decoding through the pre-decoded token byte table
+ */
+  bool test_decode_table() {
+    std::cout << "\n=== Testing Decode Table ===" << std::endl;
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "iarabicspeech_decode_table_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::string vocab_path = (dir / "vocabulary.json").string();
+
+    // "\u00d8" and "\u00a7" are the byte-level symbols of the two UTF-8 bytes of 'ا'
+    {
+      std::ofstream out(vocab_path);
+      out << "[\n  \"\\u0120the\",\n  \"\\u0120cat\",\n  \"<|endoftext|>\",\n"
+          << "  \"\\u00d8\",\n  \"\\u00a7\"\n]\n";
+    }
+
+    whisper::WhisperTokenizer tokenizer(vocab_path, true);
+    ASSERT_EQ(tokenizer.decode({0, 1}), std::string(" the cat"), "Spaces restored from BPE symbols");
+    ASSERT_EQ(tokenizer.decode({0, 2, 1}), std::string(" the cat"), "Special tokens skipped");
+    ASSERT_EQ(tokenizer.decode({0, 2}, false), std::string(" the<|endoftext|>"),
+              "Special tokens kept when requested");
+    ASSERT_EQ(tokenizer.decode({3, 4}), std::string("\xD8\xA7"), "Character split across tokens rejoined");
+    ASSERT_EQ(tokenizer.decode({whisper::WhisperTokenizer::SOT_TOKEN, 1}), std::string(" cat"),
+              "Special tokens added after loading are skipped");
+    ASSERT_EQ(tokenizer.decode({-1, 1, 1000000}), std::string(" cat"), "Unknown ids ignored");
+
+    std::filesystem::remove_all(dir);
+    return true;
+  }
+
+/**
+ * Test byte-level BPE encoding against the model vocabulary
+ */
+  bool test_bpe_encoding() {
+    std::cout << "\n=== Testing Byte-Level BPE Encoding ===" << std::endl;
+
+    std::string model_vocab = "../../../Sources/faster_whisper/model/whisper_ct2/vocabulary.json";
+    if (!std::filesystem::exists(model_vocab)) {
+      std::cout << "⚠️ Model vocabulary not found, skipping BPE test" << std::endl;
+      return true;
+    }
+
+    // Work on a copy so the vocabulary cache is not written into the source tree
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "iarabicspeech_bpe_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::string vocab_path = (dir / "vocabulary.json").string();
+    std::filesystem::copy_file(model_vocab, vocab_path);
+
+    whisper::WhisperTokenizer tokenizer(vocab_path, true);
+
+    std::vector<int> english = tokenizer.encode("hello world");
+    ASSERT_TRUE(english == std::vector<int>({675, 1913, 1002}), "English words merged by rank");
+
+    std::string arabic = "مرحبا بكم في الاختبار";
+    std::vector<int> expected = {29973, 5016, 3555, 995, 4724, 24793, 8978, 2423, 47283, 2655, 3555, 9640};
+    std::vector<int> arabic_ids = tokenizer.encode(arabic);
+    ASSERT_TRUE(arabic_ids == expected, "Arabic words merged by rank");
+    ASSERT_TRUE(tokenizer.encode(arabic) == expected, "Cached words encode the same");
+    ASSERT_EQ(tokenizer.decode(arabic_ids), arabic, "Arabic round trip");
+
+    // Harakat are split from letters like the GPT-2 pattern does, then rejoined on decode
+    std::string vocalized = "السَّلامُ عَلَيكُم";
+    ASSERT_EQ(tokenizer.decode(tokenizer.encode(vocalized)), vocalized, "Vocalized Arabic round trip");
+    ASSERT_TRUE(tokenizer.encode("it's") == std::vector<int>({270, 311}), "Contraction split");
+
+    std::filesystem::remove_all(dir);
+    return true;
+  }
+
+/**
+ * Test incremental detokenization of characters split across tokens
+ */
+  bool test_streaming_detokenizer() {
+    std::cout << "\n=== Testing Streaming Detokenizer ===" << std::endl;
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "iarabicspeech_streaming_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::string vocab_path = (dir / "vocabulary.json").string();
+
+    // "\u00d8" and "\u00a7" are the two UTF-8 bytes of 'ا', "\u00d9\u0127" is 'م'
+    {
+      std::ofstream out(vocab_path);
+      out << "[\n  \"\\u0120\",\n  \"\\u00d8\",\n  \"\\u00a7\",\n  \"\\u00d9\\u0127\",\n"
+          << "  \"<|endoftext|>\"\n]\n";
+    }
+
+    whisper::WhisperTokenizer tokenizer(vocab_path, true);
+    whisper::StreamingDetokenizer detokenizer(tokenizer);
+
+    ASSERT_EQ(detokenizer.push(0), std::string(" "), "Complete character emitted");
+    ASSERT_EQ(detokenizer.push(1), std::string(""), "Partial character held back");
+    ASSERT_EQ(detokenizer.push(2), std::string("\xD8\xA7"), "Held bytes completed by next token");
+    ASSERT_EQ(detokenizer.push({4, 3, 1}), std::string("\xD9\x85"), "Batch emits complete characters only");
+    ASSERT_EQ(detokenizer.flush(), std::string("\xD8"), "Flush returns unfinished bytes");
+
+    // Pushing one token at a time yields the same text as decoding all at once
+    std::vector<int> tokens = {0, 1, 2, 3, 4, 0, 3, 1, 2};
+    std::string streamed;
+    for (int token : tokens) {
+      streamed += detokenizer.push(token);
+    }
+    streamed += detokenizer.flush();
+    ASSERT_EQ(streamed, tokenizer.decode(tokens), "Streamed text matches decode");
+
+    std::filesystem::remove_all(dir);
+    return true;
+  }
+
+/**
+ * Test word splitting from the per-token metadata table
+ */
+  bool test_word_split() {
+    std::cout << "\n=== Testing Word Split ===" << std::endl;
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "iarabicspeech_word_split_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::string vocab_path = (dir / "vocabulary.json").string();
+
+    // " \xD8" opens 'ا' which "\u00a7" completes, "\u00d9\u0127" is 'م'
+    {
+      std::ofstream out(vocab_path);
+      out << "[\n  \"\u0120\u00d8\",\n  \"\u00a7\",\n  \"\u00d9\u0127\",\n  \".\",\n"
+          << "  \"\u0120hi\",\n  \"hi\"\n]\n";
+    }
+
+    whisper::WhisperTokenizer tokenizer(vocab_path, true);
+
+    auto [subwords, subword_tokens] = tokenizer.split_tokens_on_unicode({0, 1, 2, 3});
+    ASSERT_EQ(subwords.size(), static_cast<size_t>(3), "Subwords end on character boundaries");
+    ASSERT_EQ(subwords[0], std::string(" \xD8\xA7"), "Split character kept in one subword");
+    ASSERT_TRUE(subword_tokens[0] == std::vector<int>({0, 1}), "Subword holds both tokens");
+
+    auto [words, word_tokens] = tokenizer.split_to_word_tokens({0, 1, 2, 3, 4, 5});
+    ASSERT_EQ(words.size(), static_cast<size_t>(3), "Words split on spaces and punctuation");
+    ASSERT_EQ(words[0], std::string(" \xD8\xA7\xD9\x85"), "Arabic word joined across tokens");
+    ASSERT_TRUE(word_tokens[0] == std::vector<int>({0, 1, 2}), "Arabic word tokens");
+    ASSERT_EQ(words[1], std::string("."), "Punctuation is its own word");
+    ASSERT_EQ(words[2], std::string(" hihi"), "Subword without space joins previous word");
+
+    auto [split, split_tokens] = tokenizer.split_to_word_tokens({4, whisper::WhisperTokenizer::TIMESTAMP_BEGIN, 5});
+    ASSERT_EQ(split.size(), static_cast<size_t>(2), "Special token breaks word");
+    ASSERT_EQ(split[1], std::string("hi"), "Special token dropped");
+
+    auto [partial, partial_tokens] = tokenizer.split_to_word_tokens({0});
+    ASSERT_EQ(partial.size(), static_cast<size_t>(1), "Incomplete character kept");
+
+    std::filesystem::remove_all(dir);
+    return true;
+  }
+
+/**
+ * Test switching the language of an existing Tokenizer
+ */
+  bool test_language_switching() {
+    std::cout << "\n=== Testing Language Switching ===" << std::endl;
+
+    Tokenizer tokenizer(nullptr, true, "transcribe", "ar");
+    int ar_token = tokenizer.get_sot_sequence()[1];
+    ASSERT_EQ(tokenizer.get_language_code(), std::string("ar"), "Initial language");
+
+    Tokenizer window_tokenizer = tokenizer;
+    window_tokenizer.set_language("en");
+    const auto &en_sequence = window_tokenizer.get_sot_sequence();
+    ASSERT_EQ(en_sequence.size(), static_cast<size_t>(3), "Switched sequence keeps its length");
+    ASSERT_EQ(en_sequence[1], whisper::WhisperTokenizer::LANGUAGE_TOKEN_START, "English language token");
+    ASSERT_EQ(en_sequence[2], tokenizer.get_transcribe(), "Task token kept");
+    ASSERT_EQ(window_tokenizer.get_language_code(), std::string("en"), "Language code switched");
+    ASSERT_EQ(tokenizer.get_sot_sequence()[1], ar_token, "Original tokenizer unchanged");
+
+    window_tokenizer.set_language("ar");
+    ASSERT_EQ(window_tokenizer.get_sot_sequence()[1], ar_token, "Switched back to Arabic");
+
+    bool threw = false;
+    try {
+      window_tokenizer.set_language("xx");
+    } catch (const std::invalid_argument &) {
+      threw = true;
+    }
+    ASSERT_TRUE(threw, "Invalid language rejected");
+
+    return true;
+  }
+
+/**
+ * Test whitespace handling and Arabic folding of the text normalizer
+ */
+  bool test_text_normalizer() {
+    std::cout << "\n=== Testing Text Normalizer ===" << std::endl;
+
+    ASSERT_EQ(whisper::normalize_text("  hello \t\n world  "), std::string("hello world"),
+              "Whitespace collapsed and trimmed");
+    ASSERT_EQ(whisper::normalize_text("Hello"), std::string("Hello"), "Case preserved");
+    ASSERT_EQ(whisper::normalize_text("list\n"), std::string("list"), "Trailing letters kept");
+
+    whisper::NormalizeOptions keep_edges;
+    keep_edges.trim = false;
+    ASSERT_EQ(whisper::normalize_text("  a  b ", keep_edges), std::string(" a b "),
+              "Untrimmed text keeps one edge space");
+
+    // "مرحبــا" with tatweel, "مَرْحَبًا" with harakat, and "ﻣﺮﺣﺒﺎ" in presentation forms
+    whisper::NormalizeOptions arabic = whisper::arabic_folding_options();
+    std::string plain = "مرحبا";
+    ASSERT_EQ(whisper::normalize_text("مرحبــا", arabic), plain, "Tatweel removed");
+    ASSERT_EQ(whisper::normalize_text("مَرْحَبًا", arabic), plain, "Diacritics removed");
+    ASSERT_EQ(whisper::normalize_text("ﻣﺮﺣﺒﺎ", arabic), plain, "Presentation forms folded");
+    ASSERT_EQ(whisper::normalize_text("ﻻ", arabic), std::string("لا"), "Lam-alef ligature folded");
+    ASSERT_EQ(whisper::normalize_text("مَرْحَبًا"), std::string("مَرْحَبًا"), "Diacritics kept by default");
+
+    // Malformed UTF-8: the lead byte passes through and the bytes after it are kept
+    ASSERT_EQ(whisper::normalize_text("\xD9  a"), std::string("\xD9 a"),
+              "Lead byte before a space does not absorb it");
+    ASSERT_EQ(whisper::normalize_text("\xE2xy"), std::string("\xE2xy"),
+              "Lead byte before ASCII letters passes through");
+    ASSERT_EQ(whisper::normalize_text("ab\xE2\x82"), std::string("ab\xE2\x82"),
+              "Truncated sequence at the end passes through");
+    ASSERT_EQ(whisper::normalize_text("\x80\xD9\x85"), std::string("\x80\xD9\x85"),
+              "Stray continuation byte kept before a valid character");
+
+    // The output buffer is reused across calls
+    std::string buffer = "stale";
+    whisper::normalize_text(" x ", buffer);
+    ASSERT_EQ(buffer, std::string("x"), "Buffer cleared before writing");
+
+    return true;
+  }
+
 } // anonymous namespace
 
 /**
@@ -752,6 +1097,13 @@ bool run_tokenizer_unit_tests() {
   all_passed &= test_non_speech_tokens();
   all_passed &= test_edge_cases();
   all_passed &= test_tokenizer_wrapper();
+  all_passed &= test_vocab_cache();
+  all_passed &= test_decode_table();
+  all_passed &= test_bpe_encoding();
+  all_passed &= test_streaming_detokenizer();
+  all_passed &= test_word_split();
+  all_passed &= test_language_switching();
+  all_passed &= test_text_normalizer();
 
   // NEW VOCABULARY LOADING TESTS
   std::cout << "\n=== VOCABULARY LOADING TESTS ===" << std::endl;